@@ -13,20 +13,99 @@
 #include <string.h>
 #include <time.h>
 #include <limits.h> // pour INT_MAX
+#include <pthread.h> // pour le perft multi-thread (compiler avec -pthread)
+#include <fcntl.h>	   // pour open (fichier cache)
+#include <unistd.h>	   // pour ftruncate, close
+#include <sys/stat.h>  // pour fstat
+#include <sys/mman.h>  // pour mmap (fichier cache projeté en mémoire)
+#include <sys/file.h>  // pour flock (fichier cache partagé entre processus)
+#include <dirent.h>	   // pour parcourir le répertoire des tables de finales
+#if defined(__x86_64__)
+#include <immintrin.h> // pour _pext_u64 (BMI2)
+#endif
 
 #define MAX +1 // Joueur Maximisant
 #define MIN -1 // Joueur Minimisant
 
 #define INFINI INT_MAX
-#define MAXPARTIE 50 // Taille max du tableau Partie                                \
-					 // qui sert à vérifier si une conf a déjà été générée \
-					 // pour ne pas le re-considérer une 2e fois.                  \
-					 // On se limitera donc aux MAXPARTIE derniers coups
+#define MAXHISTORIQUE 1024 // Taille max du tableau historique des clés des positions   \
+						   // précédant la position courante (partie et recherche), \
+						   // depuis le dernier coup irréversible
+
+// Représentation de l'échiquier par bitboards (entiers de 64 bits) :
+// le bit numéro 'c' correspond à la case (x,y) avec c = 8*x + y
+// (x : ligne 0..7 correspondant aux rangées 1..8, y : colonne 0..7 correspondant à a..h)
+typedef unsigned long long bitboard;
+
+#define CASE(x, y) ((x) * 8 + (y))
+#define LIGNE(c) ((c) >> 3)
+#define COLONNE(c) ((c) & 7)
+#define BIT(c) (1ULL << (c))
+
+#define NB_BITS(b) __builtin_popcountll(b)		   // nombre de bits à 1
+#define PREMIER_BIT(b) __builtin_ctzll(b)		   // indice du bit à 1 le plus faible
+#define DERNIER_BIT(b) (63 - __builtin_clzll(b)) // indice du bit à 1 le plus fort
+
+// Couleurs (le joueur MAX joue les Blancs et le joueur MIN les Noirs)
+#define BLANC 0
+#define NOIR 1
+#define COULEUR(mode) ((mode) == MAX ? BLANC : NOIR)
+
+// Types de pièces (indices dans les bitboards de struct config)
+#define PION 0
+#define CAVALIER 1
+#define FOU 2
+#define TOUR 3
+#define REINE 4
+#define ROI 5
+
+// Masques de cases utilisés par les fonctions d'estimation
+#define CENTRE_LARGE 0x0000FFFFFFFF0000ULL // lignes 2 à 5 (rangées 3 à 6)
+#define CENTRE 0x0000003C3C000000ULL	   // cases c4 à f5
+#define RANGEES_PROMO 0xFF000000000000FFULL // rangées 1 et 8 (transformation des pions)
+#define GAUCHE 0x0F0F0F0F0F0F0F0FULL	   // colonnes a à d
+#define DROITE 0xF0F0F0F0F0F0F0F0ULL	   // colonnes e à h
+#define ATTAQUE_B1 0xFFFFFFFF00000000ULL   // lignes 4 à 7 (moitié adverse pour B)
+#define ATTAQUE_B2 0xFFFF000000000000ULL   // lignes 6 et 7
+#define ATTAQUE_N1 0x00000000FFFFFFFFULL   // lignes 0 à 3 (moitié adverse pour N)
+#define ATTAQUE_N2 0x000000000000FFFFULL   // lignes 0 et 1
+
+// Colonnes du bord, pour éliminer les débordements lors des décalages de bitboards
+#define COL_A 0x0101010101010101ULL
+#define COL_H 0x8080808080808080ULL
+#define COL_AB 0x0303030303030303ULL
+#define COL_GH 0xC0C0C0C0C0C0C0C0ULL
+
+// Attaques depuis la case c calculées par décalages (expressions constantes,
+// évaluées à la compilation pour remplir les tables attCavalier, attRoi et attPion)
+#define ATT_CAVALIER(c) ((((BIT(c) << 17) | (BIT(c) >> 15)) & ~COL_A) |  \
+						 (((BIT(c) << 15) | (BIT(c) >> 17)) & ~COL_H) |  \
+						 (((BIT(c) << 10) | (BIT(c) >> 6)) & ~COL_AB) | \
+						 (((BIT(c) << 6) | (BIT(c) >> 10)) & ~COL_GH))
+#define ATT_ROI(c) ((BIT(c) << 8) | (BIT(c) >> 8) |                                   \
+					(((BIT(c) << 1) | (BIT(c) << 9) | (BIT(c) >> 7)) & ~COL_A) | \
+					(((BIT(c) >> 1) | (BIT(c) >> 9) | (BIT(c) << 7)) & ~COL_H))
+#define ATT_PION_B(c) ((((BIT(c) << 7) & ~COL_H) | ((BIT(c) << 9) & ~COL_A)))
+#define ATT_PION_N(c) ((((BIT(c) >> 9) & ~COL_H) | ((BIT(c) >> 7) & ~COL_A)))
+
+// Liste des valeurs de M(c) pour les 64 cases (initialisation des tables constantes)
+#define LIGNE8(M, x) M(8 * x), M(8 * x + 1), M(8 * x + 2), M(8 * x + 3), \
+					 M(8 * x + 4), M(8 * x + 5), M(8 * x + 6), M(8 * x + 7)
+#define TABLE64(M) LIGNE8(M, 0), LIGNE8(M, 1), LIGNE8(M, 2), LIGNE8(M, 3), \
+				   LIGNE8(M, 4), LIGNE8(M, 5), LIGNE8(M, 6), LIGNE8(M, 7)
 
 // Type d'une configuration
 struct config
 {
-	char mat[8][8];			 // Echiquier
+	bitboard pieces[2][6];	 // Un bitboard par couleur (BLANC/NOIR) et par type de pièce (PION..ROI)
+	bitboard occ[2];		 // Cases occupées par les pièces de chaque couleur
+	bitboard occTout;		 // Cases occupées (toutes couleurs confondues)
+	char cases[64];			 // Type + 1 de la pièce sur chaque case (0 si vide), la couleur
+							 // étant donnée par occ ; tenu à jour avec les bitboards
+	bitboard cle;			 // Clé de Zobrist (pièces, roques et joueur ayant le trait)
+	bitboard clePions;		 // Clé de Zobrist des seuls pions et rois (table des pions)
+	short demiCoups;		 // Nb de demi-coups depuis la dernière prise ou le dernier 
+							 // mouvement de pion (règle des 50 coups)
 	int val;				 // Estimation de la config
 	char xrN, yrN, xrB, yrB; // Positions des rois Noir et Blanc
 	char roqueN, roqueB;	 // Indicateurs de roque pour N et B :
@@ -37,6 +116,182 @@ struct config
 							 // 'e' effectué
 };
 
+// Type d'un coup codé sur 16 bits :
+//   bits 0 à 5 : case de départ, bits 6 à 11 : case d'arrivée (pour un roque, celles du roi)
+//   bits 12 à 15 : indicateurs (combinaison des valeurs PRISE, PROMO, P_ROQUE et G_ROQUE),
+//   pour une promotion les 2 bits faibles des indicateurs donnent la pièce obtenue :
+//   0 cavalier, 1 fou, 2 tour, 3 reine (c-a-d le type de la pièce - CAVALIER)
+typedef unsigned short Coup;
+
+#define P_ROQUE 1 // petit roque
+#define G_ROQUE 2 // grand roque
+#define PRISE 4	  // prise d'une pièce adverse
+#define PROMO 8	  // transformation d'un pion
+
+#define COUP(de, vers, drap) ((Coup)((de) | ((vers) << 6) | ((drap) << 12)))
+#define DE(c) ((c)&63)
+#define VERS(c) (((c) >> 6) & 63)
+#define DRAP(c) ((c) >> 12)
+#define EST_PRISE(c) (DRAP(c) & PRISE)
+#define EST_PROMO(c) (DRAP(c) & PROMO)
+#define EST_ROQUE(c) (!EST_PROMO(c) && (DRAP(c) & (P_ROQUE | G_ROQUE)))
+#define PIECE_PROMO(c) (CAVALIER + (DRAP(c) & 3))
+#define COUP_NUL 0 // aucun coup (a1 vers a1)
+
+#define MAXCOUPS 256 // Nb max de coups générés à partir d'une configuration
+
+// Demi-largeur initiale de la fenêtre d'aspiration autour de la valeur de l'itération précédente
+// (multipliée par 4 à chaque sortie de la fenêtre, qui s'ouvre entièrement au-delà de 100)
+#define FENETRE_ASPIRATION 8
+
+// Marge de l'élagage delta de la recherche de quiescence : une prise est ignorée si même
+// le gain de la pièce prise, plus cette marge, ne suffit pas à atteindre la borne du joueur
+#define MARGE_DELTA 5
+
+// Etapes du sélecteur de coups de minmax_ab
+#define ETAPE_HACHE 0	 // coup proposé par la table de hachage (s'il est légal)
+#define ETAPE_G_PRISES 1 // génération des prises
+#define ETAPE_PRISES 2	 // prises, de la plus forte à la plus faible
+#define ETAPE_TUEURS 3	 // coups tueurs (calmes ayant provoqué une coupe au même niveau)
+#define ETAPE_G_CALMES 4 // génération des coups sans prise
+#define ETAPE_CALMES 5	 // coups sans prise, par historique des coupes décroissant
+#define ETAPE_FIN 6
+
+// passage voulu d'une étape à la suivante dans le switch de coupSuivant
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 7)
+#define ENCHAINER __attribute__((fallthrough))
+#else
+#define ENCHAINER ((void)0)
+#endif
+
+// Nature de la valeur gardée dans la table de transposition (du point de vue de MAX)
+#define BORNE_EXACTE 0 // valeur exacte
+#define BORNE_INF 1	   // la vraie valeur est au moins égale (coupe beta)
+#define BORNE_SUP 2	   // la vraie valeur est au plus égale (aucun coup n'a dépassé alpha)
+
+// Entrée de la table de transposition : 'donnee' regroupe le meilleur coup (bits 0 à 15),
+// la valeur (bits 16 à 31), la profondeur (bits 32 à 39) et la nature de la borne (bits 40-41).
+// 'verif' vaut clé ^ donnee : une entrée écrite à moitié par un autre thread ne correspond
+// à aucune clé et est simplement ignorée (pas de verrou)
+struct entreeTT
+{
+	bitboard verif, donnee;
+};
+
+// Fichier cache des analyses (partagé entre les exécutions et les processus) : un en-tête
+// puis TAILLE_CACHE_DISQUE entrées au format de la table de transposition, le fichier étant
+// projeté en mémoire (mmap) et utilisé tel quel, sans lecture ni écriture explicites
+#define TAILLE_CACHE_DISQUE (1 << 16) // nb d'entrées (puissance de 2)
+#define VERSION_CACHE 1
+struct enteteCache
+{
+	char signature[8];	   // "ECHECS" : reconnaît un fichier cache
+	unsigned int version;  // VERSION_CACHE : format des entrées
+	unsigned int nbEntrees; // TAILLE_CACHE_DISQUE
+	bitboard controle;	   // dépend des clés de Zobrist (les clés gardées doivent être les mêmes)
+};
+
+// Livre d'ouvertures propre au programme : entrées de 16 octets triées par clé, disposées
+// comme celles des fichiers Polyglot mais avec les clés de Zobrist du programme, chacune
+// formée de la clé (8 octets), du coup au format Polyglot (2), de son poids (2) et d'un champ
+// d'apprentissage (4, inutilisé), les entiers étant rangés du poids fort au poids faible.
+// Une 1re entrée d'en-tête (signature SIGNATURE_LIVRE puis valeur de contrôle des clés)
+// fait rejeter les livres construits avec d'autres clés (dont les livres Polyglot)
+#define TAILLE_ENTREE_LIVRE 16
+#define SIGNATURE_LIVRE "LIVRECH"
+struct entreeLivre
+{
+	bitboard cle;
+	unsigned short coup, poids;
+};
+
+// Tables de finales (fichiers '.fin' d'un répertoire, projetés en mémoire) : pour une
+// répartition des pièces, la valeur exacte (règles du programme : sans prise en passant, 
+// et un joueur sans coup possible a perdu) de chaque position, le trait étant aux Blancs 
+// (indices 0..nbPositions-1) puis aux Noirs. L'indice d'une position est la somme des 
+// case_k * 64^k, ses pièces étant prises par couleur (B puis N), par type puis par case.
+// Le fichier contient l'en-tête, les valeurs sur 2 bits (4 par octet) puis, sauf pour une
+// simple table gain/nulle/perte, les distances (un octet par position : nb de demi-coups avant
+// le mat ou la conversion, c-a-d la sortie de la table par une prise ou une transformation,
+// le gagnant la hâtant et le perdant la retardant)
+#define FINALE_INCONNUE 0 // position impossible ou non calculée
+#define FINALE_NULLE 1
+#define FINALE_GAIN 2  // gain pour le joueur ayant le trait
+#define FINALE_PERTE 3 // perte pour le joueur ayant le trait
+#define MAX_FINALES 64 // nb max de tables chargées
+#define VERSION_FINALE 2
+struct enteteFinale
+{
+	char signature[8];		// "FINALE"
+	unsigned int version;	// VERSION_FINALE
+	unsigned int nbPieces;	// rois compris
+	char nb[2][6];			// nb de pièces par couleur et par type
+	unsigned int distances; // 1 si les distances suivent les valeurs
+	bitboard nbPositions;	// 64^nbPieces (par joueur ayant le trait)
+};
+
+// Génération des tables par analyse rétrograde : valeurs provisoires d'une position
+// (0 tant qu'elle n'est pas décidée) et nombre de ses coups restant dans la table,
+// avec l'indicateur GEN_ISSUE si un de ses coups sortant de la table ne perd pas
+#define GEN_IMPOSSIBLE 4 // indice ne correspondant à aucune position
+#define GEN_ISSUE 0x80
+#define GEN_BLOC 4096 // nb de positions traitées à la fois par un thread
+
+// Cache des estimations (à accès direct) : une entrée de 64 bits garde les 48 bits forts
+// de la clé et l'estimation dans les 16 bits faibles (écrite d'un seul coup, donc sans verrou)
+#define TAILLE_CACHE_EST (1 << 16) // nb d'entrées (puissance de 2)
+#define VAL_CACHE_EST 0xFFFFULL
+
+// Entrée de la table des pions (à accès direct, indexée par la clé des pions et des rois) :
+// 'donnee' regroupe le score de structure des pions des Blancs (bits 0 à 15) et des Noirs
+// (bits 16 à 31), et 'verif' vaut clé ^ donnee comme pour la table de transposition
+#define TAILLE_TABLE_PIONS (1 << 14) // nb d'entrées (puissance de 2)
+struct entreePions
+{
+	bitboard verif, donnee;
+};
+
+// Table d'attaques d'une pièce glissante (fou ou tour) sur une case :
+// l'index dans 'att' est ((occ & masque) * magique) >> decal, ou bien PEXT(occ, masque)
+struct magie
+{
+	bitboard masque;  // cases pouvant bloquer les rayons (bords exclus)
+	bitboard magique; // multiplicateur sans collision destructive
+	bitboard *att;	  // début de la partie de la table propre à cette case
+	int decal;		  // 64 - nb de bits du masque
+};
+
+// Liste de coups de capacité fixe
+struct listeCoups
+{
+	int n;				// Nb de coups dans la liste
+	Coup c[MAXCOUPS];	// Les coups
+	int val[MAXCOUPS];	// Estimation de chaque coup (pour le tri des coups)
+};
+
+// Sélecteur de coups : les coups d'un noeud sont générés par étapes, au fur et à mesure
+// des besoins, pour qu'une coupe sur les premiers coups évite de générer les suivants
+struct selecteur
+{
+	int etape;			  // étape en cours (ETAPE_HACHE, ...)
+	int mode;			  // joueur ayant le trait
+	int i;				  // prochain coup de L (ou tueur) à rendre
+	int n;				  // nb de coups restant à rendre (largeur d'exploration)
+	Coup coupHache;		  // coup à essayer en premier (COUP_NUL si aucun)
+	Coup tueurs[2];		  // coups tueurs à essayer après les prises
+	struct listeCoups L;  // coups de l'étape en cours
+};
+
+// Informations nécessaires pour annuler un coup joué par jouerCoup
+struct annul
+{
+	char pris;				 // Type de la pièce prise (-1 si aucune)
+	char xrN, yrN, xrB, yrB; // Positions des rois avant le coup
+	char roqueN, roqueB;	 // Indicateurs de roque avant le coup
+	bitboard cle;			 // Clé de Zobrist avant le coup
+	short demiCoups;		 // Compteur de la règle des 50 coups avant le coup
+};
+
 /**************************/
 /* Entête des fonctions : */
 /**************************/
@@ -55,6 +310,90 @@ struct config
 */
 int minmax_ab(struct config *conf, int mode, int niv, int min, int max, int largeur, int numFctEst);
 
+/*
+  Réduction de profondeur (LMR) du coup 'c', rendu par le sélecteur 's' comme 'nbFils'-ième
+  alternative d'un noeud à 'niv' niveaux de la frontière et déjà joué sur 'conf' : 0 pour
+  les premiers coups, les prises, les tueurs, les transformations et les coups donnant échec
+  ou joués en échec ('echec' non nul), 1 ou 2 pour les coups calmes tardifs
+*/
+int reductionLMR(struct config *conf, struct selecteur *s, Coup c, int niv, int nbFils, int echec);
+
+/*
+  Recherche de quiescence, à la frontière d'exploration de minmax_ab : seules les prises
+  (et les transformations en reine) du joueur 'mode' dans 'conf' sont explorées, jusqu'à
+  une position calme, chaque joueur pouvant s'arrêter sur l'estimation 'numFctEst' de
+  la position s'il ne trouve pas mieux. Retourne la valeur ramenée dans ['alpha', 'beta']
+*/
+int quiescence(struct config *conf, int mode, int alpha, int beta, int numFctEst);
+
+/*
+  Recherche par approfondissement itératif le meilleur des coups 'L' du joueur 'mode' dans
+  'conf' : les profondeurs 0, 1, ... 'hauteur' sont explorées tour à tour, le meilleur coup
+  de l'itération précédente en premier, tant que le budget du coup (tempsCoup, noeudsMax)
+  n'est pas épuisé. Retourne l'indice dans 'L' du coup choisi (-1 s'il n'y en a pas),
+  sa valeur dans 'score' et la dernière profondeur entièrement explorée dans 'prof'
+*/
+int chercherCoup(struct config *conf, int mode, struct listeCoups *L, int hauteur, int largeur,
+				 int numFctEst, int *score, int *prof);
+
+/*
+  Explore à la profondeur 'niv' les 'n' premiers coups 'L' du joueur 'mode' dans 'conf',
+  pour l'intervalle ['alpha', 'beta'] : retourne la valeur de la racine ramenée dans cet
+  intervalle et dans 'meilleur' l'indice du meilleur coup (-1 si aucun ne dépasse
+  la borne de départ du joueur)
+*/
+int explorerRacine(struct config *conf, int mode, struct listeCoups *L, int n, int niv,
+				   int alpha, int beta, int largeur, int numFctEst, int *meilleur);
+
+/*
+  Place le coup d'indice 'j' de 'L' en tête de liste, sans changer l'ordre des autres
+*/
+void avancerCoup(struct listeCoups *L, int j);
+
+/*
+  Partage entre les threads de recherche l'exploration à la profondeur 'niv' des coups
+  'premier' à 'n'-1 de 'L' (joueur 'mode', racine 'conf'). Si 'pleine' est non nul, chaque
+  coup est évalué dans toute la fenêtre et sa valeur rangée dans 'L->val' ; sinon les coups
+  doivent battre la borne 'borne' du meilleur coup 'meilleur' déjà exploré, dans l'intervalle
+  ['alpha', 'beta'] : retourne alors la nouvelle borne, et dans 'meilleur' son coup
+*/
+int partagerRacine(struct config *conf, int mode, struct listeCoups *L, int premier, int n, int niv,
+				   int alpha, int beta, int borne, int pleine, int largeur, int numFctEst, int *meilleur);
+
+/*
+  Thread de l'exploration partagée de la racine numéro 'arg' (0 pour le thread principal)
+*/
+void *racineThread(void *arg);
+
+/*
+  Thread auxiliaire de la recherche Lazy SMP numéro 'arg' : explore la racine smpRacine
+  par approfondissement itératif jusqu'à l'arrêt demandé par le thread principal,
+  pour remplir la table de transposition partagée
+*/
+void *rechercheAuxiliaire(void *arg);
+
+/*
+  Commence le décompte du temps et des noeuds de la recherche d'un coup
+*/
+void debutRecherche();
+
+/*
+  Retourne le temps écoulé (en ms) depuis le début de la recherche du coup en cours
+*/
+long tempsEcoule();
+
+/*
+  Retourne 1 (et le note dans arretRecherche) si le budget de temps ou de noeuds
+  de la recherche en cours est épuisé
+*/
+int budgetEpuise();
+
+/*
+  Retourne le temps (en ms) alloué au prochain coup d'un joueur disposant de 'restant' ms
+  à sa pendule et de 'increment' ms par coup joué, sans dépasser 'tempsMax' (si non nul)
+*/
+long allouerTemps(long restant, long increment, long tempsMax);
+
 /* 
   La fonction d'estimation à utiliser, retourne une valeur dans ]-100, +100[ 
   quelques fonctions d'estimation disponibles (comme exemples).
@@ -68,46 +407,164 @@ int estim5(struct config *conf);
 int estim6(struct config *conf);
 /* Votre propre fonction d'estimation */
 int estim7(struct config *conf);
+/* Estimation avec structure des pions (doublés, isolés, passés, bouclier du roi) */
+int estim8(struct config *conf);
 
 /* 
-  Génère les successeurs de la configuration 'conf' dans le tableau 'T', 
-  Retourne aussi dans 'n' le nb de configurations filles générées.
+  Génère dans la liste 'L' les coups légaux du joueur 'mode' à partir de 'conf' 
+  (ceux ne laissant pas son roi en échec).
+  Les pièces donnant échec et les pièces clouées sont calculées une seule fois, 
+  de sorte que seuls des coups légaux sont générés.
+*/
+void generer_coups(struct config *conf, int mode, struct listeCoups *L);
+
+/*
+  Comme generer_coups, en ne gardant que les coups dont la case d'arrivée appartient à 'cibles'
+  (les cases adverses pour les prises, les cases vides pour les coups calmes)
+*/
+void generer_coups_vers(struct config *conf, int mode, bitboard cibles, struct listeCoups *L);
+
+/*
+  Teste si 'c' est un coup légal du joueur 'mode' dans 'conf'
+*/
+int coupLegal(struct config *conf, int mode, Coup c);
+
+/*
+  Génère dans 'L' les roques possibles du joueur de couleur 'coul' dont la case d'arrivée
+  du roi appartient à 'cibles'
 */
-void generer_succ(struct config *conf, int mode, struct config T[], int *n);
+void roques(struct config *conf, int coul, bitboard cibles, struct listeCoups *L);
+
+/*
+  Joue le coup 'c' sur la configuration 'conf' (modifiée sur place) 
+  en gardant dans 'u' les informations nécessaires pour l'annuler
+*/
+void jouerCoup(struct config *conf, Coup c, struct annul *u);
+
+/*
+  Annule le coup 'c' joué sur 'conf' par jouerCoup (avec les informations de 'u')
+*/
+void dejouerCoup(struct config *conf, Coup c, struct annul *u);
 
 /* 
-  Génère dans 'T' les configurations obtenues à partir de 'conf' lorsqu'un pion (a,b) 
-  va atteindre la limite de l'échiquier (x,y)
+  Génère dans 'L' les coups obtenus lorsqu'un pion de la case 'de' 
+  va atteindre la limite de l'échiquier en 'vers' ('prise' vaut PRISE ou 0)
 */
-void transformPion(struct config *conf, int a, int b, int x, int y, struct config T[], int *n);
+void transformPion(int de, int vers, int prise, struct listeCoups *L);
 
 /* 
-  Génere dans 'T' tous les coups possibles de la pièce (de couleur N ou B) 
-  se trouvant à la pos 'x','y'
+  Génere dans 'L' les coups de la pièce de couleur 'coul' et de type 'type' se trouvant 
+  sur la case 'c' dont la case d'arrivée appartient à 'permis' (hors roques)
+*/
+void deplacements(struct config *conf, int coul, int type, int c, bitboard permis, struct listeCoups *L);
+
+/*
+  Retourne les pièces de la couleur 'coul' attaquant la case 'c', 
+  les cases occupées de 'occ' arrêtant les rayons des pièces glissantes
+*/
+bitboard attaquants(struct config *conf, int c, int coul, bitboard occ);
+
+/*
+  Teste si le roi de la couleur 'coul' est en échec dans 'conf'
 */
-void deplacementsN(struct config *conf, int x, int y, struct config T[], int *n);
-void deplacementsB(struct config *conf, int x, int y, struct config T[], int *n);
+int enEchec(struct config *conf, int coul);
+
+/*
+  Ajoute le coup 'c' à la fin de la liste 'L'
+*/
+void ajouterCoup(struct listeCoups *L, Coup c);
 
 /* 
   Vérifie si la case (x,y) est menacée par une des pièces du joueur 'mode'
 */
 int caseMenaceePar(int mode, int x, int y, struct config *conf);
 
+/*
+  Retourne l'ensemble des cases attaquées par les pièces de la couleur 'coul'
+*/
+bitboard attaquesCouleur(struct config *conf, int coul);
+
+/*
+  Cases attaquées par un fou ou une tour placé(e) sur la case 'c', 
+  les cases occupées de 'occ' arrêtant les rayons
+*/
+bitboard attFou(int c, bitboard occ);
+bitboard attTour(int c, bitboard occ);
+
+/*
+  Cases attaquées depuis la case 'c' dans la direction 'i' du tableau D 
+  (calcul rayon par rayon, utilisé seulement pour construire les tables magiques)
+*/
+bitboard attRayon(int i, int c, bitboard occ);
+
+/*
+  Construit pour chaque case la table d'attaques du fou (dirDeb == 1) ou de la tour (dirDeb == 0)
+  indexée par les nombres magiques 'mag' (ou par PEXT si disponible)
+*/
+void initMagiques(struct magie mag[64], bitboard *table, int dirDeb);
+
+/*
+  Initialise les tables d'attaques des pièces glissantes et les clés de Zobrist 
+  (à appeler une seule fois)
+*/
+void initBitboards();
+
+/*
+  Tire les nombres aléatoires des clés de Zobrist (appelée par initBitboards)
+*/
+void initZobrist();
+
+/*
+  Calcule entièrement la clé de Zobrist de 'conf', le joueur 'mode' ayant le trait
+  (la clé est ensuite tenue à jour par poserPiece, enleverPiece et jouerCoup)
+*/
+bitboard calculerCle(struct config *conf, int mode);
+
+/*
+  Retourne le type de la pièce de couleur 'coul' se trouvant sur la case 'c' (-1 si aucune)
+*/
+int typeEn(struct config *conf, int coul, int c);
+
+/*
+  Pose (resp. enlève) une pièce de couleur 'coul' et de type 'type' sur la case 'c'
+*/
+void poserPiece(struct config *conf, int coul, int type, int c);
+void enleverPiece(struct config *conf, int coul, int type, int c);
+
+/*
+  Retourne l'indicateur de roque 'roque' mis à jour lorsque le grand (cote == 'g') 
+  ou le petit (cote == 'p') roque devient impossible
+*/
+char perteRoque(char roque, char cote);
+
+/*
+  Construit dans 'mat' l'échiquier (codes signés des pièces) correspondant à 'conf'
+  (utilisé uniquement pour l'affichage et la sauvegarde)
+*/
+void versMatrice(struct config *conf, char mat[8][8]);
+
 /*
   Intialise la disposition des pieces dans la configuration initiale 'conf'
 */
 void init(struct config *conf);
 
+/*
+  Initialise 'conf' et le joueur 'mode' à partir de la notation FEN 'fen' 
+  (la case de prise en passant est ignorée). Retourne 0 si 'fen' est incorrecte, ou si le roi
+  du joueur n'ayant pas le trait est en échec
+*/
+int lireFEN(struct config *conf, char *fen, int *mode);
+
 /* 
   Affiche la configuration 'conf'
 */
 void affich(struct config *conf, char *coup, int num);
 
 /*
-  Teste si 'conf' représente une configuration déjà jouée (dans le tableau Partie)
-  auquel cas elle retourne le num du coup + 1
+  Teste si 'conf' est nulle par la règle des 50 coups ou parce qu'elle figure déjà 'nbRep' fois 
+  dans l'historique (1 fois suffit dans la recherche, 2 fois dans la partie : triple répétition)
 */
-int dejaVisitee(struct config *conf);
+int partieNulle(struct config *conf, int nbRep);
 
 /* 
   Savegarde la config 'conf' dans le fichier f (global)
@@ -119,11 +576,6 @@ void sauvConf(struct config *conf);
 */
 void copier(struct config *c1, struct config *c2);
 
-/* 
-  Teste si les 2 grilles (échiquiers) 'c1' et 'c2' sont égales
-*/
-int egal(char c1[8][8], char c2[8][8]);
-
 /*
   Teste s'il n'y a aucun coup possible à partir de la configuration 'conf'
 */
@@ -131,29 +583,186 @@ int AucunCoupPossible(struct config *conf);
 
 /* 
   Teste si 'conf' représente une fin de partie 
-  et retourne dans 'cout' son score -100, 0 ou +100
+  et retourne dans 'cout' son score -100, 0 ou +100 (±99 pour une finale gagnée des tables)
 */
 int feuille(struct config *conf, int *cout);
 
 /*
-  Comparaisons des configurations 'a' et 'b' pour le compte de qsort 
-  pour l'ordre croissant (confcmp123) et décroissant (confcmp321)
+  Nombre de feuilles de l'arbre des coups légaux de profondeur 'prof' à partir de 'conf'
+  (le joueur 'mode' ayant le trait)
+*/
+long long perft(struct config *conf, int mode, int prof);
+
+/*
+  Programme perft : perft <prof> [-fen "<FEN>"] [-divide] [-hash <Mo>] [-threads <n>]
+*/
+int perftMain(int argc, char *argv[]);
+
+/*
+  Projette en mémoire (en lecture seule) le livre d'ouvertures 'nomf'. Retourne 0 en cas d'échec
+  ou si le fichier n'est pas un livre construit par le programme avec les mêmes clés de Zobrist
+*/
+int ouvrirLivre(char *nomf);
+
+/*
+  Code au format Polyglot du coup 'c' (un roque y est noté comme la prise de la tour par le roi)
+*/
+unsigned short coupPolyglot(Coup c);
+
+/*
+  Cherche dans le livre d'ouvertures un coup de la liste 'L' des coups légaux dans 'conf'.
+  S'il y en a, retourne 1 et dans 'c' le coup choisi au hasard suivant les poids (ou celui 
+  de plus fort poids si livreMeilleur vaut 1)
+*/
+int coupLivre(struct config *conf, struct listeCoups *L, Coup *c);
+
+/*
+  Charge les tables de finales (fichiers '.fin') du répertoire 'rep'. Retourne leur nombre
+*/
+int ouvrirFinales(char *rep);
+
+/*
+  Cherche dans les tables de finales la valeur de 'conf' pour le joueur 'mode' ayant le trait.
+  Retourne 1 avec dans 'val' FINALE_NULLE, FINALE_GAIN ou FINALE_PERTE, et dans 'dist' 
+  (si non NULL) la distance avant le mat ou la conversion, si la position est dans une table
+*/
+int sonderFinale(struct config *conf, int mode, int *val, int *dist);
+
+/*
+  Valeur de 'conf' dans les tables de finales quand elle ne dépend pas du joueur ayant le trait
+  (utilisée par feuille et les estimations, qui ne le connaissent pas) : retourne 1 avec dans 
+  'score' 0 (nulle), +99 (gain des Blancs) ou -99 (gain des Noirs)
+*/
+int valeurFinale(struct config *conf, int *score);
+
+/*
+  Si 'conf' est dans les tables de finales, retourne 1 avec dans 'c' le coup de 'L' à jouer
+  (le plus court chemin vers le gain, le plus long vers la perte, ou un coup gardant la nulle)
+  et dans 'score' la valeur de la position pour minmax_ab
+*/
+int coupFinale(struct config *conf, int mode, struct listeCoups *L, Coup *c, int *score);
+
+/*
+  Programme de génération des tables de finales : finales <répertoire> [-pieces <3|4>] 
+  [-threads <n>] [-wdl] (tables gain/nulle/perte seules, sans les distances)
+*/
+int finalesMain(int argc, char *argv[]);
+
+/*
+  Programme de construction d'un livre : livre <livre.bin> <ouvertures.txt>, chaque ligne du
+  fichier texte étant une suite de coups à partir de la position initiale (par exemple e2e4 e7e5)
+*/
+int livreMain(int argc, char *argv[]);
+
+/*
+  Alloue une table de transposition de 'mo' Mo (arrondie à une puissance de 2 d'entrées)
+*/
+void initTT(int mo);
+
+/*
+  Ouvre (en le créant ou le réinitialisant au besoin) le fichier cache 'nomf' et le projette 
+  en mémoire. Retourne 0 si le fichier ne peut pas être utilisé (la partie se joue alors sans)
+*/
+int ouvrirCache(char *nomf);
+
+/*
+  Écrit sur disque les analyses du fichier cache et le ferme
+*/
+void fermerCache();
+
+/*
+  Cherche dans le fichier cache l'analyse de la racine 'conf' (joueur 'mode', profondeur 'prof',
+  largeur 'largeur', estimation 'numFctEst'). Retourne 1 (avec 'score' et le coup légal 'coup')
+  si elle a déjà été faite à une profondeur au moins égale
+*/
+int sonderCache(struct config *conf, int mode, int prof, int largeur, int numFctEst, int *score, Coup *coup);
+
+/*
+  Range dans le fichier cache le résultat 'score' et 'coup' de l'analyse de la racine 'conf'
+*/
+void rangerCache(struct config *conf, int mode, int prof, int largeur, int numFctEst, int score, Coup coup);
+
+/*
+  Cherche la clé 'cle' dans la table de transposition. Retourne dans 'coup' le meilleur coup 
+  gardé (COUP_NUL si aucun) et retourne 1 si l'entrée, de profondeur au moins 'prof', 
+  donne directement la valeur 'score' de minmax_ab pour l'intervalle ['alpha', 'beta']
+*/
+int sonderTT(bitboard cle, int prof, int alpha, int beta, int *score, Coup *coup);
+
+/*
+  Range dans la table de transposition la valeur 'score' de nature 'borne' et le meilleur 
+  coup 'coup' obtenus à la profondeur 'prof' pour la clé 'cle'
+*/
+void stockerTT(bitboard cle, int prof, int score, int borne, Coup coup);
+
+/*
+  Numéro de la fonction d'estimation réellement utilisée par Est['numFctEst'] au coup
+  num_coup (estim6 change d'estimation suivant la phase de la partie)
+*/
+int estimEffective(int numFctEst);
+
+/*
+  Retourne l'estimation de 'conf' par la fonction 'numFctEst', en la cherchant d'abord
+  dans le cache des estimations (elle n'est calculée et rangée qu'en cas d'absence), sauf pour
+  estim3 dont la perturbation aléatoire est tirée à chaque appel
+*/
+int estimer(struct config *conf, int numFctEst);
+
+/*
+  Ajoute aux totaux les compteurs de statistiques du thread appelant (et les remet à 0),
+  à sa fin pour un thread de recherche et avant l'affichage pour le thread principal
+*/
+void reporterStatistiques();
+
+/*
+  Trie les coups de 'L' suivant leurs estimations 'val' : 
+  dans l'ordre décroissant pour le joueur MAX et croissant pour le joueur MIN
+*/
+void trierCoups(struct listeCoups *L, int mode);
+
+/*
+  Prépare dans 's' la sélection des coups du joueur 'mode', 'coupHache'
+  étant essayé en premier et les 2 coups 'tueurs' après les prises. Seuls les 'largeur'
+  premiers coups dans cet ordre seront rendus
 */
-int confcmp123(const void *a, const void *b);
-int confcmp321(const void *a, const void *b);
+void initSelecteur(struct selecteur *s, int mode, Coup coupHache, Coup *tueurs, int largeur);
+
+/*
+  Retourne le prochain coup à explorer (COUP_NUL s'il n'y en a plus) : le coup de hachage,
+  puis les prises (MVV-LVA : plus forte victime, puis plus faible attaquant), les coups
+  tueurs et enfin les coups calmes (par historique des coupes), chaque étape n'étant
+  générée que lorsque la précédente est épuisée
+*/
+Coup coupSuivant(struct config *conf, struct selecteur *s);
+
+/*
+  Note le coup calme 'c' du joueur de couleur 'coul', qui a provoqué une coupe à 'niv' niveaux
+  de la frontière, comme coup tueur de la profondeur courante et dans l'historique des coupes
+*/
+void noterCoupe(int coul, Coup c, int niv);
+
+/*
+  Atténue l'historique des coupes (pour qu'il ne déborde pas et que les coupes récentes
+  y pèsent davantage)
+*/
+void attenuerHistoCoupes();
 
 /* 
-  Génère dans 'coup' un texte décrivant le dernier coup effectué (pour l'affichage)
-  en comparant deux configurations: l'ancienne 'oldconf' et la nouvelle 'newconf'
+  Génère dans 'coup' un texte décrivant le coup 'c' (pour l'affichage),
+  'conf' étant la configuration à partir de laquelle il est joué
 */
-void formuler_coup(struct config *oldconf, struct config *newconf, char *coup);
+void formuler_coup(struct config *conf, Coup c, char *coup);
 
 /************************/
 /* Variables Globales : */
 /************************/
 
-// Tableau de config pour garder la trace des conf déjà visitées
-struct config Partie[MAXPARTIE];
+// Clés des positions précédant la position courante (dans la partie puis sur le chemin de
+// la recherche), pour détecter les répétitions ; les positions antérieures au dernier
+// coup irréversible de la partie sont oubliées. Comme tout l'état propre à une recherche
+// (compteurs, tueurs, historique des coupes), elles sont locales à chaque thread de recherche
+__thread bitboard historique[MAXHISTORIQUE];
+__thread int nbHistorique = 0;
 
 // Fichier pour sauvegarder l'historique des parties
 FILE *f;
@@ -170,15 +779,147 @@ int (*Est[10])(struct config *);
 // nb de fonctions d'estimation dans le tableau précédent
 int nbEst;
 
-// vecteurs pour générer les différents déplacements par type de pièce ...
-//    cavalier :
-int dC[8][2] = {{-2, +1}, {-1, +2}, {+1, +2}, {+2, +1}, {+2, -1}, {+1, -2}, {-1, -2}, {-2, -1}};
-//    fou (indices impairs), tour (indices pairs), reine et roi (indices pairs et impairs):
+// vecteurs des directions des pièces glissantes ...
+//    fou (indices impairs), tour (indices pairs), reine (indices pairs et impairs):
 int D[8][2] = {{+1, 0}, {+1, +1}, {0, +1}, {-1, +1}, {-1, 0}, {-1, -1}, {0, -1}, {+1, -1}};
 
-// pour statistques sur le nombre de coupes effectuées
-int nbAlpha = 0;
-int nbBeta = 0;
+// codes des pièces par type (PION..ROI), utilisés pour l'affichage et la sauvegarde
+char codePiece[6] = {'p', 'c', 'f', 't', 'n', 'r'};
+
+// valeurs des pièces par type à l'échelle des estimations (poids de materiel * 100/76),
+// pour l'élagage delta de la recherche de quiescence
+int valeurPiece[6] = {3, 8, 8, 11, 26, 0};
+
+// tables d'attaques du cavalier, du roi et des pions (par couleur) depuis chaque case,
+// générées à la compilation :
+const bitboard attCavalier[64] = {TABLE64(ATT_CAVALIER)};
+const bitboard attRoi[64] = {TABLE64(ATT_ROI)};
+const bitboard attPion[2][64] = {{TABLE64(ATT_PION_B)}, {TABLE64(ATT_PION_N)}};
+
+// tables d'attaques précalculées par initBitboards() :
+//    rayons depuis chaque case dans chacune des 8 directions de D (sans la case de départ)
+bitboard rayons[8][64];
+//    cases strictement entre 2 cases alignées (0 si elles ne sont pas alignées)
+bitboard entre[64][64];
+//    attaques des fous et des tours par case et par occupation (bitboards magiques)
+struct magie magieFou[64], magieTour[64];
+bitboard tableFou[5248], tableTour[102400];
+//    index des tables calculé par l'instruction PEXT (si le processeur dispose de BMI2)
+int avecPext = 0;
+
+// nombres aléatoires des clés de Zobrist : une pièce sur une case, chaque indicateur 
+// de roque (indexé directement par son caractère 'r', 'g', 'p', 'n' ou 'e') et le trait aux Noirs
+bitboard zobPiece[2][6][64], zobRoque[2][128], zobTrait;
+//    et une clé par fonction d'estimation, pour que les valeurs de la table de transposition
+//    obtenues avec des estimations différentes ne se mélangent pas
+bitboard zobEst[10];
+
+// cache des estimations et ses compteurs de succès / échecs (statistiques) : chaque thread
+// compte dans les siens, qui sont ajoutés aux totaux par reporterStatistiques
+bitboard cacheEst[TAILLE_CACHE_EST];
+__thread long long nbEstTrouvees = 0;
+__thread long long nbEstCalculees = 0;
+long long nbEstTrouveesTous = 0;
+long long nbEstCalculeesTous = 0;
+
+// table des pions (scores de structure des pions) et ses compteurs de succès / échecs,
+// par thread comme ceux du cache des estimations
+struct entreePions tablePions[TAILLE_TABLE_PIONS];
+__thread long long nbPionsTrouves = 0;
+__thread long long nbPionsCalcules = 0;
+long long nbPionsTrouvesTous = 0;
+long long nbPionsCalculesTous = 0;
+
+// table de transposition de minmax_ab, partagée par tous les appels (et tous les threads)
+struct entreeTT *tableTT = NULL;
+bitboard masqueTT;
+
+// entrées du livre d'ouvertures projeté en mémoire (NULL si non utilisé), leur nombre
+// et le mode de choix des coups (0 : au hasard suivant les poids, 1 : plus fort poids)
+unsigned char *livre = NULL;
+long nbEntreesLivre = 0;
+int livreMeilleur = 0;
+
+// tables de finales chargées (en-têtes projetés) et plus grand nombre de pièces de ces tables
+// (0 si aucune : les finales ne sont alors jamais cherchées)
+struct enteteFinale *finales[MAX_FINALES];
+int nbFinales = 0;
+int nbPiecesFinales = 0;
+
+// table en cours de génération et son état, partagés par les threads de génération
+struct enteteFinale *genTable;
+unsigned char *genVal, *genFils;
+unsigned short *genDist;
+bitboard genProchain; // prochain bloc de positions à traiter
+int genNiveau;		  // distance des positions dont on cherche les prédécesseurs
+int genNouveaux;	  // indique si des positions ont été décidées au niveau suivant
+
+// fichier cache projeté en mémoire (NULL si non utilisé) : en-tête et entrées
+struct enteteCache *enteteCache = NULL;
+struct entreeTT *tableCache = NULL;
+int fdCache = -1;
+
+// pour statistques sur le nombre de coupes effectuées (par thread)
+__thread int nbAlpha = 0;
+__thread int nbBeta = 0;
+
+// ordre des coups calmes : 2 coups tueurs par profondeur du chemin de recherche (indexés
+// comme historique), et historique des coupes par couleur, case de départ et case d'arrivée
+__thread Coup tueurs[MAXHISTORIQUE + 1][2];
+__thread int histoCoupes[2][64][64];
+
+// statistiques de la sélectivité de minmax_ab : coups nuls essayés et coupes obtenues,
+// coups réduits (LMR) et réexplorations à pleine profondeur (par thread)
+__thread long long nbEssaisNuls = 0, nbCoupesNulles = 0;
+__thread long long nbReductions = 0, nbReexplorations = 0;
+
+// budget de la recherche d'un coup (0 : illimité), en ms et en nombre de noeuds : minmax_ab
+// le contrôle tous les 1024 noeuds et abandonne la recherche dès qu'il est épuisé, sauf
+// pendant la 1re itération du thread principal (il faut bien un coup à jouer).
+// Chaque thread compte ses noeuds dans nbNoeuds et les reporte par 1024 dans nbNoeudsTous
+long tempsCoup = 0;
+long long noeudsMax = 0;
+__thread long long nbNoeuds = 0;
+long long nbNoeudsTous = 0;
+struct timespec debutCoup;
+volatile int interruptible = 0;
+volatile int arretRecherche = 0;
+
+// Lazy SMP : nb de threads de recherche (option -threads <n>) et racine explorée par les
+// threads auxiliaires, qui ne partagent avec le thread principal que la table de
+// transposition (et les caches des estimations et des pions)
+int nbThreadsRecherche = 1;
+struct config smpRacine;
+struct listeCoups smpL;
+int smpMode, smpHauteur, smpLargeur, smpEst, smpNbHistorique;
+bitboard *smpHistorique;
+
+// Partage de la racine (option -racine, à la place du Lazy SMP) : les coups de la racine
+// sont répartis entre les threads (prochain coup à prendre dans parProchain). Une fois
+// le 1er coup exploré seul, les autres doivent battre la borne commune parBorne (Young
+// Brothers Wait), mise à jour avec parMeilleur sous le verrou parVerrou
+int partageRacine = 0;
+struct config parRacine;
+struct listeCoups *parL;
+int parMode, parNiv, parAlpha, parBeta, parPleine, parLargeur, parEst, parN, parProchain;
+volatile int parBorne;
+int parMeilleur;
+pthread_mutex_t parVerrou = PTHREAD_MUTEX_INITIALIZER;
+
+// table de hachage du perft (NULL si non utilisée) : une entrée garde le nombre de feuilles
+// et la profondeur dans 'donnee', et 'verif' = clé ^ donnee pour détecter les entrées
+// à moitié écrites par un autre thread
+struct entreePerft
+{
+	bitboard verif, donnee;
+} *tablePerft = NULL;
+bitboard masquePerft;
+
+// répartition des coups de la racine du perft entre les threads
+struct config perftRacine;
+struct listeCoups perftL;
+long long perftNb[MAXCOUPS];
+int perftMode, perftProf, perftProchain;
 
 /*******************************************/
 /*********** Programme principal  **********/
@@ -189,16 +930,39 @@ int main(int argc, char *argv[])
 
 	int n, i, j, score, stop, cout, hauteur, largeur, tour, estMin, estMax;
 
-	int sx, dx, cout2, legal;
+	int sx, dx, cout2, legal, promo, de, vers;
 	int cmin, cmax;
-	int typeExec, refaire;
+	int typeExec, refaire, prof;
+	long tempsMax, increment, pendule[2];
 
 	char coup[20] = "";
 	char nomf[20]; // nom du fichier de sauvegarde
 	char ch[100];
 	char sy, dy;
 
-	struct config T[100], conf, conf1;
+	struct config conf, conf1;
+	struct listeCoups L;
+	struct annul u;
+	Coup c;
+
+	// mode perft (test et mesure de la génération des coups) ...
+	if (argc > 1 && strcmp(argv[1], "perft") == 0)
+		return perftMain(argc, argv);
+
+	// génération des tables de finales ...
+	if (argc > 1 && strcmp(argv[1], "finales") == 0)
+		return finalesMain(argc, argv);
+
+	// construction d'un livre d'ouvertures ...
+	if (argc > 1 && strcmp(argv[1], "livre") == 0)
+		return livreMain(argc, argv);
+
+	// taille en Mo de la table de transposition (option -hash <Mo>, 32 par défaut)
+	j = 32;
+	for (i = 1; i + 1 < argc; i++)
+		if (strcmp(argv[i], "-hash") == 0)
+			j = atoi(argv[i + 1]);
+	initTT(j);
 
 	// initialiser le tableau des fonctions d'estimation
 	Est[0] = estim1;
@@ -208,8 +972,9 @@ int main(int argc, char *argv[])
 	Est[4] = estim5;
 	Est[5] = estim6;
 	Est[6] = estim7;
+	Est[7] = estim8;
 	// Nombre de fonctions d'estimation disponibles
-	nbEst = 7;
+	nbEst = 8;
 
 	// Choix du type d'exécution (pc-contre-pc ou user-contre-pc) ...
 	printf("Type de parties (B:Blancs  N:Noirs) :\n");
@@ -231,7 +996,8 @@ int main(int argc, char *argv[])
 		printf("4- basée sur le nb de pieces et les menaces\n");
 		printf("5- basée sur le nb de pieces et l'occupation\n");
 		printf("6- basée sur une combinaisant de 3 estimations: (2 -> 5 -> 4)\n");
-		printf("7- une fonction d'estimation aléatoire (à définir) \n\n");
+		printf("7- une fonction d'estimation aléatoire (à définir) \n");
+		printf("8- basée sur le nb de pièces, l'occupation, la structure des pions et la défense du roi\n\n");
 		if (typeExec != 3)
 		{
 			printf("Donnez la fonction d'estimation utilisée par le PC pour le joueur B : ");
@@ -272,10 +1038,54 @@ int main(int argc, char *argv[])
 	if (largeur == 0)
 		largeur = +INFINI;
 
-	// Initialise la configuration de départ
+	// Initialise les tables d'attaques puis la configuration de départ
+	initBitboards();
 	init(&conf);
-	for (i = 0; i < MAXPARTIE; i++)
-		copier(&conf, &Partie[i]);
+
+	// fichier cache des analyses des racines (option -cache <fichier>), dont l'en-tête
+	// dépend des clés de Zobrist tirées par initBitboards
+	for (i = 1; i + 1 < argc; i++)
+		if (strcmp(argv[i], "-cache") == 0 && !ouvrirCache(argv[i + 1]))
+			printf("Fichier cache '%s' inutilisable, la partie se joue sans\n", argv[i + 1]);
+
+	// tables de finales (option -finales <répertoire>)
+	for (i = 1; i + 1 < argc; i++)
+		if (strcmp(argv[i], "-finales") == 0)
+			printf("%d tables de finales chargées depuis '%s'\n", ouvrirFinales(argv[i + 1]), argv[i + 1]);
+
+	// livre d'ouvertures (option -livre <fichier>, et -livreMax pour jouer le coup de plus fort poids)
+	for (i = 1; i < argc; i++)
+		if (strcmp(argv[i], "-livre") == 0 && i + 1 < argc && !ouvrirLivre(argv[i + 1]))
+			printf("Livre d'ouvertures '%s' inutilisable, la partie se joue sans\n", argv[i + 1]);
+		else if (strcmp(argv[i], "-livreMax") == 0)
+			livreMeilleur = 1;
+
+	// budget de chaque coup du PC : temps (option -temps <ms>) et nombre de noeuds (option
+	// -noeuds <n>), la profondeur maximale restant une limite ; partie à la pendule (option
+	// -pendule <s> pour chaque joueur, et -increment <ms> rajoutées après chaque coup)
+	tempsMax = increment = 0;
+	pendule[BLANC] = pendule[NOIR] = -1;
+	for (i = 1; i + 1 < argc; i++)
+		if (strcmp(argv[i], "-temps") == 0)
+			tempsMax = atol(argv[i + 1]);
+		else if (strcmp(argv[i], "-noeuds") == 0)
+			noeudsMax = atoll(argv[i + 1]);
+		else if (strcmp(argv[i], "-pendule") == 0)
+			pendule[BLANC] = pendule[NOIR] = 1000 * atol(argv[i + 1]);
+		else if (strcmp(argv[i], "-increment") == 0)
+			increment = atol(argv[i + 1]);
+
+	// nb de threads de la recherche (option -threads <n>, Lazy SMP ou, avec l'option -racine,
+	// partage des coups de la racine)
+	for (i = 1; i < argc; i++)
+		if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+			nbThreadsRecherche = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-racine") == 0)
+			partageRacine = 1;
+	if (nbThreadsRecherche < 1)
+		nbThreadsRecherche = 1;
+	if (nbThreadsRecherche > 64)
+		nbThreadsRecherche = 64;
 
 	num_coup = 0;
 
@@ -305,8 +1115,21 @@ int main(int argc, char *argv[])
 	{
 
 		affich(&conf, coup, num_coup);
-		copier(&conf, &Partie[num_coup % MAXPARTIE]); // rajouter conf au tableau 'Partie'
 		sauvConf(&conf);
+
+		// match nul par triple répétition ou par la règle des 50 coups ...
+		if (partieNulle(&conf, 2))
+		{
+			printf("\n *** match nul (%s) ***\n",
+				   (conf.demiCoups >= 100 ? "règle des 50 coups" : "triple répétition"));
+			fprintf(f, "Match nul\n");
+			break;
+		}
+
+		// rajouter conf à l'historique (qui peut repartir de zéro après un coup irréversible)
+		if (conf.demiCoups == 0)
+			nbHistorique = 0;
+		historique[nbHistorique++] = conf.cle;
 		refaire = 0; // indicateur de coup illegal, pour refaire le mouvement
 
 		if (tour == MAX)
@@ -321,88 +1144,66 @@ int main(int argc, char *argv[])
 					printf("Donnez srcY srcX destY destX (par exemple d2d3) : ");
 					fgets(ch, 100, stdin);
 					i = sscanf(ch, " %c %d %c %d", &sy, &sx, &dy, &dx);
+					if (i == 4 && (sy < 'a' || sy > 'h' || dy < 'a' || dy > 'h' ||
+								   sx < 1 || sx > 8 || dx < 1 || dx > 8))
+						i = 0;
 					if (i != 4)
 						printf("Lecture incorrecte, recommencer ...\n");
 				} while (i != 4);
 
-				copier(&conf, &conf1);
-
 				// Traitement du coup du joueur ...
-
-				if (sx == conf.xrB + 1 && sy - 'a' == conf.yrB && dy == sy + 2)
-				{ // petit roque ...
-					//if (sy == '0') { // petit roque ...
-					conf1.mat[0][4] = 0;
-					conf1.mat[0][7] = 0;
-					conf1.mat[0][6] = 'r';
-					conf1.xrB = 0;
-					conf1.yrB = 6;
-					conf1.mat[0][5] = 't';
-					conf1.roqueB = 'e';
-				}
-				else if (sx == conf.xrB + 1 && sy - 'a' == conf.yrB && dy == sy - 2)
-				{ // grand roque ...
-					//if (sy == '1') {  // grand roque ...
-					conf1.mat[0][4] = 0;
-					conf1.mat[0][0] = 0;
-					conf1.mat[0][2] = 'r';
-					conf1.xrB = 0;
-					conf1.yrB = 2;
-					conf1.mat[0][3] = 't';
-					conf1.roqueB = 'e';
-				}
-				else
-				{ // deplacement normal (les autres coups) ...
-					conf1.mat[dx - 1][dy - 'a'] = conf1.mat[sx - 1][sy - 'a'];
-					conf1.mat[sx - 1][sy - 'a'] = 0;
-					// vérifier possibilité de transformation d'un pion arrivé en fin d'échiquier ...
-					if (dx == 8 && conf1.mat[dx - 1][dy - 'a'] == 'p')
+				// (un roque est donné par le déplacement du roi, par exemple e1g1)
+				de = CASE(sx - 1, sy - 'a');
+				vers = CASE(dx - 1, dy - 'a');
+				promo = -1;
+				// vérifier possibilité de transformation d'un pion arrivé en fin d'échiquier ...
+				if (dx == 8 && typeEn(&conf, BLANC, de) == PION)
+				{
+					printf("Pion arrivé en ligne 8, transformer en (p/c/f/t/n) : ");
+					scanf(" %s", ch);
+					switch (ch[0])
 					{
-						printf("Pion arrivé en ligne 8, transformer en (p/c/f/t/n) : ");
-						scanf(" %s", ch);
-						switch (ch[0])
-						{
-						case 'c':
-							conf1.mat[dx - 1][dy - 'a'] = 'c';
-							break;
-						case 'f':
-							conf1.mat[dx - 1][dy - 'a'] = 'f';
-							break;
-						case 't':
-							conf1.mat[dx - 1][dy - 'a'] = 't';
-							break;
-						case 'p':
-							conf1.mat[dx - 1][dy - 'a'] = 'p';
-							break;
-						default:
-							conf1.mat[dx - 1][dy - 'a'] = 'n';
-						}
+					case 'c':
+						promo = CAVALIER;
+						break;
+					case 'f':
+						promo = FOU;
+						break;
+					case 't':
+						promo = TOUR;
+						break;
+					case 'p':
+						promo = -1; // le pion reste un pion
+						break;
+					default:
+						promo = REINE;
 					}
 				}
 
-				// vérifier si victoire (le roi N n'existe plus) ...
-				if (conf1.xrN == dx - 1 && conf1.yrN == dy - 'a')
-				{
-					conf1.xrN = -1;
-					conf1.yrN = -1;
-				}
-
 				// vérification de la légalité du coup effectué par le joueur ...
-				generer_succ(&conf, MAX, T, &n);
+				generer_coups(&conf, MAX, &L);
 
 				legal = 0;
-				for (i = 0; i < n && !legal; i++)
-					if (egal(T[i].mat, conf1.mat))
+				for (i = 0; i < L.n && !legal; i++)
+					if (DE(L.c[i]) == de && VERS(L.c[i]) == vers &&
+						(EST_PROMO(L.c[i]) ? PIECE_PROMO(L.c[i]) : -1) == promo)
 						legal = 1;
 
+				if (legal)
+				{
+					// le coup est joué sur conf1 (une éventuelle prise du roi N y est aussi notée)
+					i--;
+					copier(&conf, &conf1);
+					jouerCoup(&conf1, L.c[i], &u);
+				}
+
 				if (legal && !feuille(&conf1, &cout))
 				{
 					printf("OK\n\n");
-					i--;
-					formuler_coup(&conf, &T[i], coup);
-					copier(&T[i], &conf);
+					formuler_coup(&conf, L.c[i], coup);
+					copier(&conf1, &conf);
 				}
-				else if (!legal && n > 0)
+				else if (!legal && L.n > 0)
 				{
 					printf("Coup illégal (%c%d%c%d) -- réessayer\n", sy, sx, dy, dx);
 					refaire = 1; // pour forcer la prochaine itération à rester MAX
@@ -417,48 +1218,60 @@ int main(int argc, char *argv[])
 				printf("Au tour du joueur maximisant PC 'B' ");
 				fflush(stdout);
 
-				generer_succ(&conf, MAX, T, &n);
+				generer_coups(&conf, MAX, &L);
+				n = L.n;
 				printf("\nhauteur = %d    nb alternatives = %d : ", hauteur, n);
 				fflush(stdout);
 
-				// Iterative Deepening ...
-				// On effectue un tri sur les alternatives selon l'estimation de leur qualité
-				// Le but est d'explorer les alternatives les plus prometteuses d'abord
-				// pour maximiser les coupes lors des évaluation minmax avec alpha-bêta
+				// temps alloué à ce coup (d'après la pendule) et début du décompte
+				tempsCoup = (pendule[BLANC] >= 0 ? allouerTemps(pendule[BLANC], increment, tempsMax) : tempsMax);
+				debutRecherche();
 
-				// 1- on commence donc par une petite exploration de profondeur h0
-				//    pour récupérer des estimations plus précises sur chaque coups:
-				for (i = 0; i < n; i++)
-					T[i].val = minmax_ab(&T[i], MIN, h0, -INFINI, +INFINI, largeur, estMax);
-
-				// 2- on réalise le tri des alternatives T suivant les estimations récupérées:
-				qsort(T, n, sizeof(struct config), confcmp321);
-				if (largeur < n)
-					n = largeur;
-
-				// 3- on lance l'exploration des alternatives triées avec la profondeur voulue:
-				score = -INFINI;
-				j = -1;
-
-				for (i = 0; i < n; i++)
+				// 0- un coup du livre d'ouvertures ou des tables de finales est joué sans recherche,
+				//    et la position a peut-être déjà été analysée à cette profondeur (fichier cache)
+				if (coupLivre(&conf, &L, &c))
 				{
-					nbAlpha = nbBeta = 0;
-					cout = minmax_ab(&T[i], MIN, hauteur, score, +INFINI, largeur, estMax);
-					printf(".");
-					fflush(stdout);
-					// printf(" %4d", cout); fflush(stdout);
-					if (cout > score)
-					{ // Choisir le meilleur coup (c-a-d le plus grand score)
-						score = cout;
-						j = i;
+					for (j = 0; L.c[j] != c; j++)
+						;
+					score = conf.val;
+					printf("(livre) ");
+				}
+				else if (coupFinale(&conf, MAX, &L, &c, &score))
+				{
+					for (j = 0; L.c[j] != c; j++)
+						;
+					printf("(finale) ");
+				}
+				else if (sonderCache(&conf, MAX, hauteur, largeur, estMax, &score, &c))
+				{
+					for (j = 0; L.c[j] != c; j++)
+						;
+					printf("(cache) ");
+				}
+				else
+				{
+					// Iterative Deepening jusqu'à la profondeur voulue (ou l'épuisement du budget)
+					j = chercherCoup(&conf, MAX, &L, hauteur, largeur, estMax, &score, &prof);
+					if (j != -1)
+					{
+						printf(" prof %d (%ld ms, %lld noeuds, %d coupes, coups nuls %lld/%lld, LMR %lld/%lld)",
+							   prof, tempsEcoule(), nbNoeudsTous, nbAlpha + nbBeta, nbCoupesNulles, nbEssaisNuls,
+							   nbReexplorations, nbReductions);
+						rangerCache(&conf, MAX, prof, largeur, estMax, score, L.c[j]);
 					}
 				}
 				if (j != -1)
 				{ // jouer le coup et aller à la prochaine itération ...
 					printf("\n");
-					formuler_coup(&conf, &T[j], coup);
-					copier(&T[j], &conf);
+					formuler_coup(&conf, L.c[j], coup);
+					jouerCoup(&conf, L.c[j], &u);
 					conf.val = score;
+					// la pendule est décomptée du temps pris, et perd la partie si elle tombe
+					if (pendule[BLANC] >= 0 && (pendule[BLANC] += increment - tempsEcoule()) < 0)
+					{
+						printf("\n *** temps épuisé ***");
+						stop = 1;
+					}
 				}
 				else // S'il n'y a pas de successeur possible, le joueur MAX à perdu
 					stop = 1;
@@ -485,88 +1298,66 @@ int main(int argc, char *argv[])
 					printf("Donnez srcY srcX destY destX (par exemple d7d5) : ");
 					fgets(ch, 100, stdin);
 					i = sscanf(ch, " %c %d %c %d", &sy, &sx, &dy, &dx);
+					if (i == 4 && (sy < 'a' || sy > 'h' || dy < 'a' || dy > 'h' ||
+								   sx < 1 || sx > 8 || dx < 1 || dx > 8))
+						i = 0;
 					if (i != 4)
 						printf("Lecture incorrecte, recommencer ...\n");
 				} while (i != 4);
 
-				copier(&conf, &conf1);
-
 				// Traitement du coup du joueur ...
-
-				if (sx == conf.xrN + 1 && sy - 'a' == conf.yrN && dy == sy + 2)
-				{ // petit roque ...
-					//if (sy == '0') { // petit roque ...
-					conf1.mat[7][4] = 0;
-					conf1.mat[7][7] = 0;
-					conf1.mat[7][6] = -'r';
-					conf1.xrN = 7;
-					conf1.yrN = 6;
-					conf1.mat[7][5] = -'t';
-					conf1.roqueN = 'e';
-				}
-				else if (sx == conf.xrN + 1 && sy - 'a' == conf.yrN && dy == sy - 2)
-				{ // grand roque ...
-					//if (sy == '1') {  // grand roque ...
-					conf1.mat[7][4] = 0;
-					conf1.mat[7][0] = 0;
-					conf1.mat[7][2] = -'r';
-					conf1.xrN = 7;
-					conf1.yrN = 2;
-					conf1.mat[7][3] = -'t';
-					conf1.roqueN = 'e';
-				}
-				else
-				{ // deplacement normal (les autres coups) ...
-					conf1.mat[dx - 1][dy - 'a'] = conf1.mat[sx - 1][sy - 'a'];
-					conf1.mat[sx - 1][sy - 'a'] = 0;
-					// vérifier possibilité de transformation d'un pion arrivé en fin d'échiquier ...
-					if (dx == 1 && conf1.mat[dx - 1][dy - 'a'] == -'p')
+				// (un roque est donné par le déplacement du roi, par exemple e8g8)
+				de = CASE(sx - 1, sy - 'a');
+				vers = CASE(dx - 1, dy - 'a');
+				promo = -1;
+				// vérifier possibilité de transformation d'un pion arrivé en fin d'échiquier ...
+				if (dx == 1 && typeEn(&conf, NOIR, de) == PION)
+				{
+					printf("Pion arrivé en ligne 8, transformer en (p/c/f/t/n) : ");
+					scanf(" %s", ch);
+					switch (ch[0])
 					{
-						printf("Pion arrivé en ligne 8, transformer en (p/c/f/t/n) : ");
-						scanf(" %s", ch);
-						switch (ch[0])
-						{
-						case 'c':
-							conf1.mat[dx - 1][dy - 'a'] = -'c';
-							break;
-						case 'f':
-							conf1.mat[dx - 1][dy - 'a'] = -'f';
-							break;
-						case 't':
-							conf1.mat[dx - 1][dy - 'a'] = -'t';
-							break;
-						case 'p':
-							conf1.mat[dx - 1][dy - 'a'] = -'p';
-							break;
-						default:
-							conf1.mat[dx - 1][dy - 'a'] = -'n';
-						}
+					case 'c':
+						promo = CAVALIER;
+						break;
+					case 'f':
+						promo = FOU;
+						break;
+					case 't':
+						promo = TOUR;
+						break;
+					case 'p':
+						promo = -1; // le pion reste un pion
+						break;
+					default:
+						promo = REINE;
 					}
 				}
 
-				// vérifier si victoire (le roi B n'existe plus) ...
-				if (conf1.xrB == dx - 1 && conf1.yrB == dy - 'a')
-				{
-					conf1.xrB = -1;
-					conf1.yrB = -1;
-				}
-
 				// vérification de la légalité du coup effectué par le joueur ...
-				generer_succ(&conf, MIN, T, &n);
+				generer_coups(&conf, MIN, &L);
 
 				legal = 0;
-				for (i = 0; i < n && !legal; i++)
-					if (egal(T[i].mat, conf1.mat))
+				for (i = 0; i < L.n && !legal; i++)
+					if (DE(L.c[i]) == de && VERS(L.c[i]) == vers &&
+						(EST_PROMO(L.c[i]) ? PIECE_PROMO(L.c[i]) : -1) == promo)
 						legal = 1;
 
+				if (legal)
+				{
+					// le coup est joué sur conf1 (une éventuelle prise du roi B y est aussi notée)
+					i--;
+					copier(&conf, &conf1);
+					jouerCoup(&conf1, L.c[i], &u);
+				}
+
 				if (legal && !feuille(&conf1, &cout))
 				{
 					printf("OK\n\n");
-					i--;
-					formuler_coup(&conf, &T[i], coup);
-					copier(&T[i], &conf);
+					formuler_coup(&conf, L.c[i], coup);
+					copier(&conf1, &conf);
 				}
-				else if (!legal && n > 0)
+				else if (!legal && L.n > 0)
 				{
 					printf("Coup illégal (%c%d%c%d) -- réessayer\n", sy, sx, dy, dx);
 					refaire = 1; // pour forcer la prochaine itération à rester MIN
@@ -581,47 +1372,62 @@ int main(int argc, char *argv[])
 				printf("Au tour du joueur minimisant PC 'N' ");
 				fflush(stdout);
 
-				// Générer tous les coups possibles pour le joueur N dans le tableau T
-				generer_succ(&conf, MIN, T, &n);
+				// Générer tous les coups possibles pour le joueur N dans la liste L
+				generer_coups(&conf, MIN, &L);
+				n = L.n;
 				printf("\nnb alternatives = %d : ", n);
 				fflush(stdout);
 
-				// Iterative Deepening ...
-				// On effectue un tri sur les alternatives selon l'estimation de leur qualité
-				// Le but est d'explorer les alternatives les plus prometteuses d'abord
-				// pour maximiser les coupes lors des évaluation minmax avec alpha-bêta
-
-				// 1- on commence donc par une petite exploration de profondeur 3
-				//    pour récupérer des estimations plus précises sur chaque coups:
-				for (i = 0; i < n; i++)
-					T[i].val = minmax_ab(&T[i], MAX, 3, -INFINI, +INFINI, largeur, estMin);
-
-				// 2- on réalise le tri des alternatives T suivant les estimations récupérées:
-				qsort(T, n, sizeof(struct config), confcmp123);
-				if (largeur < n)
-					n = largeur;
-
-				// 3- on lance l'exploration des alternatives triées avec la profondeur voulue:
-				score = +INFINI;
-				j = -1;
-				for (i = 0; i < n; i++)
+				// temps alloué à ce coup (d'après la pendule) et début du décompte
+				tempsCoup = (pendule[NOIR] >= 0 ? allouerTemps(pendule[NOIR], increment, tempsMax) : tempsMax);
+				debutRecherche();
+
+				// 0- un coup du livre d'ouvertures ou des tables de finales est joué sans recherche,
+				//    et la position a peut-être déjà été analysée à cette profondeur (fichier cache)
+				if (coupLivre(&conf, &L, &c))
 				{
-					cout = minmax_ab(&T[i], MAX, hauteur, -INFINI, score, largeur, estMin);
-					printf(".");
-					fflush(stdout);
-					if (cout < score)
-					{ // Choisir le meilleur coup (c-a-d le plus petit score)
-						score = cout;
-						j = i;
+					for (j = 0; L.c[j] != c; j++)
+						;
+					score = conf.val;
+					printf("(livre) ");
+				}
+				else if (coupFinale(&conf, MIN, &L, &c, &score))
+				{
+					for (j = 0; L.c[j] != c; j++)
+						;
+					printf("(finale) ");
+				}
+				else if (sonderCache(&conf, MIN, hauteur, largeur, estMin, &score, &c))
+				{
+					for (j = 0; L.c[j] != c; j++)
+						;
+					printf("(cache) ");
+				}
+				else
+				{
+					// Iterative Deepening jusqu'à la profondeur voulue (ou l'épuisement du budget)
+					j = chercherCoup(&conf, MIN, &L, hauteur, largeur, estMin, &score, &prof);
+					if (j != -1)
+					{
+						printf(" prof %d (%ld ms, %lld noeuds, %d coupes, coups nuls %lld/%lld, LMR %lld/%lld)",
+							   prof, tempsEcoule(), nbNoeudsTous, nbAlpha + nbBeta, nbCoupesNulles, nbEssaisNuls,
+							   nbReexplorations, nbReductions);
+						rangerCache(&conf, MIN, prof, largeur, estMin, score, L.c[j]);
 					}
 				}
 				if (j != -1)
 				{ // jouer le coup et aller à la prochaine itération ...
 					// printf("\nchoix = %d (le coup num %d)\n", score, j+1);
 					printf("\n");
-					formuler_coup(&conf, &T[j], coup);
-					copier(&T[j], &conf);
+					formuler_coup(&conf, L.c[j], coup);
+					jouerCoup(&conf, L.c[j], &u);
 					conf.val = score;
+					// la pendule est décomptée du temps pris, et perd la partie si elle tombe
+					if (pendule[NOIR] >= 0 && (pendule[NOIR] += increment - tempsEcoule()) < 0)
+					{
+						printf("\n *** temps épuisé ***");
+						stop = 1;
+					}
 				}
 				else // S'il n'y a pas de successeur possible, le joueur MIN à perdu
 					stop = 1;
@@ -641,10 +1447,16 @@ int main(int argc, char *argv[])
 			num_coup++;
 			tour = (tour == MIN ? MAX : MIN);
 		}
+		else
+			nbHistorique--; // conf sera rajoutée de nouveau
 
 	} // while
 
+	fermerCache();
 	printf("\nFin de partie\n");
+	reporterStatistiques();
+	printf("Cache des estimations : %lld trouvées, %lld calculées\n", nbEstTrouveesTous, nbEstCalculeesTous);
+	printf("Table des pions : %lld trouvées, %lld calculées\n", nbPionsTrouvesTous, nbPionsCalculesTous);
 
 	return 0;
 
@@ -658,26 +1470,42 @@ int main(int argc, char *argv[])
 // Partie: Fonctions utilitaires
 // *****************************
 
+/* Construit dans mat l'échiquier correspondant à conf (pour l'affichage et la sauvegarde) */
+void versMatrice(struct config *conf, char mat[8][8])
+{
+	int c;
+
+	memset(mat, 0, 64);
+	for (c = 0; c < 64; c++)
+		if (conf->cases[c])
+			mat[LIGNE(c)][COLONNE(c)] = (conf->occ[BLANC] & BIT(c) ? codePiece[conf->cases[c] - 1]
+																 : -codePiece[conf->cases[c] - 1]);
+
+} // fin de versMatrice
+
 /* Sauvegarder conf dans le fichier f (pour l'historique) */
 void sauvConf(struct config *conf)
 {
 
 	char buf[72] = "";
+	char mat[8][8];
 	int i, j;
+
+	versMatrice(conf, mat);
 	for (i = 7; i >= 0; i--)
 	{
 		for (j = 0; j < 8; j++)
-			if (conf->mat[i][j] == 0)
+			if (mat[i][j] == 0)
 				strcat(buf, " ");
-			else if (conf->mat[i][j] < 0)
+			else if (mat[i][j] < 0)
 			{
 				strcat(buf, "-");
-				buf[strlen(buf) - 1] = -conf->mat[i][j];
+				buf[strlen(buf) - 1] = -mat[i][j];
 			}
 			else
 			{
 				strcat(buf, "+");
-				buf[strlen(buf) - 1] = conf->mat[i][j] - 32;
+				buf[strlen(buf) - 1] = mat[i][j] - 32;
 			}
 		strcat(buf, "\n");
 	}
@@ -689,26 +1517,18 @@ void sauvConf(struct config *conf)
 /* Intialise la disposition des pieces dans la configuration initiale conf */
 void init(struct config *conf)
 {
-	int i, j;
-
-	for (i = 0; i < 8; i++)
-		for (j = 0; j < 8; j++)
-			conf->mat[i][j] = 0; // Les cases vides sont initialisées avec 0
+	int j;
+	// ordre des pièces sur la première rangée, de la colonne a à la colonne h
+	int rangee[8] = {TOUR, CAVALIER, FOU, REINE, ROI, FOU, CAVALIER, TOUR};
 
-	conf->mat[0][0] = 't';
-	conf->mat[0][1] = 'c';
-	conf->mat[0][2] = 'f';
-	conf->mat[0][3] = 'n';
-	conf->mat[0][4] = 'r';
-	conf->mat[0][5] = 'f';
-	conf->mat[0][6] = 'c';
-	conf->mat[0][7] = 't';
+	memset(conf, 0, sizeof(struct config)); // Les cases vides correspondent aux bits à 0
 
 	for (j = 0; j < 8; j++)
 	{
-		conf->mat[1][j] = 'p';
-		conf->mat[6][j] = -'p';
-		conf->mat[7][j] = -conf->mat[0][j];
+		poserPiece(conf, BLANC, rangee[j], CASE(0, j));
+		poserPiece(conf, BLANC, PION, CASE(1, j));
+		poserPiece(conf, NOIR, PION, CASE(6, j));
+		poserPiece(conf, NOIR, rangee[j], CASE(7, j));
 	}
 
 	conf->xrB = 0;
@@ -720,90 +1540,119 @@ void init(struct config *conf)
 	conf->roqueN = 'r';
 
 	conf->val = 0;
+	conf->cle = calculerCle(conf, MAX);
 
 } // fin de init
 
-/* génère un texte décrivant le dernier coup effectué (pour l'affichage) */
-void formuler_coup(struct config *oldconf, struct config *newconf, char *coup)
+/* Lit la configuration conf et le joueur qui a le trait à partir de la notation FEN fen */
+int lireFEN(struct config *conf, char *fen, int *mode)
 {
-	int i, j;
-	char piece[20];
+	int x = 7, y = 0, type, coul;
+	char *lettres = "PNBRQK"; // codes FEN des pièces de PION à ROI
+
+	memset(conf, 0, sizeof(struct config));
+	conf->roqueB = 'n';
+	conf->roqueN = 'n';
 
-	// verifier si roqueB effectué ...
-	if (newconf->roqueB == 'e' && oldconf->roqueB != 'e')
+	// placement des pièces, de la rangée 8 à la rangée 1 ...
+	for (; *fen && *fen != ' '; fen++)
 	{
-		if (newconf->yrB == 2)
-			sprintf(coup, "g_roqueB");
+		if (*fen == '/')
+		{
+			x--;
+			y = 0;
+		}
+		else if (*fen >= '1' && *fen <= '8')
+			y += *fen - '0';
 		else
-			sprintf(coup, "p_roqueB");
-		return;
+		{
+			coul = (*fen >= 'a' ? NOIR : BLANC);
+			if (!strchr(lettres, (coul == NOIR ? *fen - 32 : *fen)) || x < 0 || y > 7)
+				return 0;
+			type = strchr(lettres, (coul == NOIR ? *fen - 32 : *fen)) - lettres;
+			poserPiece(conf, coul, type, CASE(x, y));
+			if (type == ROI && coul == BLANC)
+			{
+				conf->xrB = x;
+				conf->yrB = y;
+			}
+			if (type == ROI && coul == NOIR)
+			{
+				conf->xrN = x;
+				conf->yrN = y;
+			}
+			y++;
+		}
 	}
+	if (NB_BITS(conf->pieces[BLANC][ROI]) != 1 || NB_BITS(conf->pieces[NOIR][ROI]) != 1)
+		return 0;
+
+	// joueur ayant le trait ...
+	while (*fen == ' ')
+		fen++;
+	*mode = (*fen == 'b' ? MIN : MAX);
+	if (*fen)
+		fen++;
+
+	// le roi du joueur qui n'a pas le trait ne peut pas être en échec (il serait pris)
+	coul = COULEUR(*mode);
+	if (attaquants(conf, PREMIER_BIT(conf->pieces[1 - coul][ROI]), coul, conf->occTout))
+		return 0;
+
+	// roques encore possibles ('g' : seul le grand roque est perdu, 'p' : seul le petit)
+	while (*fen == ' ')
+		fen++;
+	if (strchr(fen, 'K') && strchr(fen, 'Q'))
+		conf->roqueB = 'r';
+	else if (strchr(fen, 'K'))
+		conf->roqueB = 'g';
+	else if (strchr(fen, 'Q'))
+		conf->roqueB = 'p';
+	if (strchr(fen, 'k') && strchr(fen, 'q'))
+		conf->roqueN = 'r';
+	else if (strchr(fen, 'k'))
+		conf->roqueN = 'g';
+	else if (strchr(fen, 'q'))
+		conf->roqueN = 'p';
+
+	// compteur de la règle des 50 coups (après la case de prise en passant), s'il est donné
+	if (sscanf(fen, "%*s %*s %d", &x) == 1)
+		conf->demiCoups = x;
+
+	conf->cle = calculerCle(conf, *mode);
+	return 1;
+
+} // fin de lireFEN
+
+/* génère un texte décrivant le coup c joué à partir de conf (pour l'affichage) */
+void formuler_coup(struct config *conf, Coup c, char *coup)
+{
+	int coul, type;
+	char *piece[2][6] = {{"pionB", "cavalierB", "fouB", "tourB", "reineB", "roiB"},
+						 {"pionN", "cavalierN", "fouN", "tourN", "reineN", "roiN"}};
+
+	coul = (conf->occ[BLANC] & BIT(DE(c)) ? BLANC : NOIR);
 
-	// verifier si roqueN effectué ...
-	if (newconf->roqueN == 'e' && oldconf->roqueN != 'e')
+	// verifier si c'est un roque ...
+	if (EST_ROQUE(c))
 	{
-		if (newconf->yrN == 2)
-			sprintf(coup, "g_roqueN");
-		else
-			sprintf(coup, "p_roqueN");
+		sprintf(coup, "%c_roque%c", (DRAP(c) & G_ROQUE ? 'g' : 'p'), (coul == BLANC ? 'B' : 'N'));
 		return;
 	}
 
-	// Autres mouvements de pièces
-	for (i = 0; i < 8; i++)
-		for (j = 0; j < 8; j++)
-			if (oldconf->mat[i][j] != newconf->mat[i][j])
-				if (newconf->mat[i][j] != 0)
-				{
-					switch (newconf->mat[i][j])
-					{
-					case -'p':
-						sprintf(piece, "pionN");
-						break;
-					case 'p':
-						sprintf(piece, "pionB");
-						break;
-					case -'c':
-						sprintf(piece, "cavalierN");
-						break;
-					case 'c':
-						sprintf(piece, "cavalierB");
-						break;
-					case -'f':
-						sprintf(piece, "fouN");
-						break;
-					case 'f':
-						sprintf(piece, "fouB");
-						break;
-					case -'t':
-						sprintf(piece, "tourN");
-						break;
-					case 't':
-						sprintf(piece, "tourB");
-						break;
-					case -'n':
-						sprintf(piece, "reineN");
-						break;
-					case 'n':
-						sprintf(piece, "reineB");
-						break;
-					case -'r':
-						sprintf(piece, "roiN");
-						break;
-					case 'r':
-						sprintf(piece, "roiB");
-						break;
-					}
-					sprintf(coup, "%s en %c%d", piece, 'a' + j, i + 1);
-					return;
-				}
+	// Autres mouvements de pièces : la pièce (éventuellement transformée) et sa case d'arrivée
+	type = (EST_PROMO(c) ? PIECE_PROMO(c) : typeEn(conf, coul, DE(c)));
+	sprintf(coup, "%s en %c%d", piece[coul][type], 'a' + COLONNE(VERS(c)), LIGNE(VERS(c)) + 1);
+
 } // fin de formuler_coup
 
 /* Affiche la configuration conf */
 void affich(struct config *conf, char *coup, int num)
 {
 	int i, j, k;
-	int pB = 0, pN = 0, cB = 0, cN = 0, fB = 0, fN = 0, tB = 0, tN = 0, nB = 0, nN = 0;
+	char mat[8][8];
+
+	versMatrice(conf, mat);
 
 	printf("Coup num:%3d : %s\n", num, coup);
 	printf("\n");
@@ -820,45 +1669,12 @@ void affich(struct config *conf, char *coup, int num)
 		printf("    %d", i);
 		for (j = 0; j < 8; j++)
 		{
-			if (conf->mat[i - 1][j] < 0)
-				printf("\t  %cN", -conf->mat[i - 1][j]);
-			else if (conf->mat[i - 1][j] > 0)
-				printf("\t  %cB", conf->mat[i - 1][j]);
+			if (mat[i - 1][j] < 0)
+				printf("\t  %cN", -mat[i - 1][j]);
+			else if (mat[i - 1][j] > 0)
+				printf("\t  %cB", mat[i - 1][j]);
 			else
 				printf("\t   ");
-			switch (conf->mat[i - 1][j])
-			{
-			case -'p':
-				pN++;
-				break;
-			case 'p':
-				pB++;
-				break;
-			case -'c':
-				cN++;
-				break;
-			case 'c':
-				cB++;
-				break;
-			case -'f':
-				fN++;
-				break;
-			case 'f':
-				fB++;
-				break;
-			case -'t':
-				tN++;
-				break;
-			case 't':
-				tB++;
-				break;
-			case -'n':
-				nN++;
-				break;
-			case 'n':
-				nB++;
-				break;
-			}
 		}
 		printf("\n");
 
@@ -867,7 +1683,12 @@ void affich(struct config *conf, char *coup, int num)
 		printf("\n");
 	}
 	printf("\n\tB : p(%d) c(%d) f(%d) t(%d) n(%d) \t N : p(%d) c(%d) f(%d) t(%d) n(%d)\n\n",
-		   pB, cB, fB, tB, nB, pN, cN, fN, tN, nN);
+		   NB_BITS(conf->pieces[BLANC][PION]), NB_BITS(conf->pieces[BLANC][CAVALIER]),
+		   NB_BITS(conf->pieces[BLANC][FOU]), NB_BITS(conf->pieces[BLANC][TOUR]),
+		   NB_BITS(conf->pieces[BLANC][REINE]),
+		   NB_BITS(conf->pieces[NOIR][PION]), NB_BITS(conf->pieces[NOIR][CAVALIER]),
+		   NB_BITS(conf->pieces[NOIR][FOU]), NB_BITS(conf->pieces[NOIR][TOUR]),
+		   NB_BITS(conf->pieces[NOIR][REINE]));
 	printf("\n");
 
 } // fin de  affich
@@ -875,46 +1696,23 @@ void affich(struct config *conf, char *coup, int num)
 /* Copie la configuration c1 dans c2  */
 void copier(struct config *c1, struct config *c2)
 {
-	int i, j;
-
-	for (i = 0; i < 8; i++)
-		for (j = 0; j < 8; j++)
-			c2->mat[i][j] = c1->mat[i][j];
-
-	c2->val = c1->val;
-	c2->xrB = c1->xrB;
-	c2->yrB = c1->yrB;
-	c2->xrN = c1->xrN;
-	c2->yrN = c1->yrN;
-
-	c2->roqueB = c1->roqueB;
-	c2->roqueN = c1->roqueN;
+	*c2 = *c1;
 } // fin de copier
 
-/* Teste si les échiquiers c1 et c2 sont égaux */
-int egal(char c1[8][8], char c2[8][8])
+/* Teste si conf est nulle (règle des 50 coups ou répétition) : seules les clés des positions
+   de même trait depuis le dernier coup irréversible peuvent être égales à celle de conf */
+int partieNulle(struct config *conf, int nbRep)
 {
-	int i, j;
+	int i, n = 0;
 
-	for (i = 0; i < 8; i++)
-		for (j = 0; j < 8; j++)
-			if (c1[i][j] != c2[i][j])
-				return 0;
-	return 1;
-} // fin de egal
+	if (conf->demiCoups >= 100)
+		return 1;
+	for (i = nbHistorique - 2; i >= 0 && i >= nbHistorique - conf->demiCoups; i -= 2)
+		if (historique[i] == conf->cle && ++n >= nbRep)
+			return 1;
+	return 0;
 
-/* Teste si conf a déjà été jouée (dans le tableau partie) */
-int dejaVisitee(struct config *conf)
-{
-	int i = 0;
-	int trouv = 0;
-	while (i < MAXPARTIE && trouv == 0)
-		if (egal(conf->mat, Partie[i].mat))
-			trouv = i + 1;
-		else
-			i++;
-	return trouv;
-}
+} // fin de partieNulle
 
 // ***********************************
 // Partie:  Evaluations et Estimations
@@ -924,7 +1722,7 @@ int dejaVisitee(struct config *conf)
 int AucunCoupPossible(struct config *conf)
 {
 	// ... A completer pour les matchs nuls
-	// ... vérifier que generer_succ retourne 0 configurations filles ...
+	// ... vérifier que generer_coups retourne 0 coups ...
 	// ... ou qu'une même configuration a été générée plusieurs fois ...
 	return 0;
 
@@ -955,6 +1753,10 @@ int feuille(struct config *conf, int *cout)
 	if (conf->xrB != -1 && conf->xrN != -1 && AucunCoupPossible(conf))
 		return 1;
 
+	// Finale dont la valeur exacte est dans les tables (quel que soit le joueur ayant le trait)
+	if (valeurFinale(conf, cout))
+		return 1;
+
 	// Sinon ce n'est pas une config feuille
 	return 0;
 
@@ -963,53 +1765,130 @@ int feuille(struct config *conf, int *cout)
 /* Quelques exemples de fonctions d'estimation simples (estim1, estim2, ...) */
 /* Voir fonction estim plus bas pour le choix l'estimation à utiliser */
 
-/* cette estimation est basée uniquement sur le nombre de pièces */
-int estim1(struct config *conf)
+/* Somme pondérée des pièces du joueur 'coul' (pion:2  cavalier/fou:6  tour:8  et  reine:20) */
+int materiel(struct config *conf, int coul)
 {
+	return NB_BITS(conf->pieces[coul][PION]) * 2 +
+		   NB_BITS(conf->pieces[coul][CAVALIER] | conf->pieces[coul][FOU]) * 6 +
+		   NB_BITS(conf->pieces[coul][TOUR]) * 8 +
+		   NB_BITS(conf->pieces[coul][REINE]) * 20;
+} // fin de materiel
+
+/* Bonus d'occupation du centre des pièces de 'coul' : 1 dans les rangées 3 à 6, 2 au centre (c4..f5),
+   multiplié par 4 pour les cavaliers, fous et reines, les tours et le roi n'étant pas comptés */
+int occupationCentre(struct config *conf, int coul)
+{
+	bitboard p = conf->pieces[coul][PION];
+	bitboard cfn = conf->pieces[coul][CAVALIER] | conf->pieces[coul][FOU] | conf->pieces[coul][REINE];
 
-	int i, j, ScrQte;
-	int pionB = 0, pionN = 0, cfB = 0, cfN = 0, tB = 0, tN = 0, nB = 0, nN = 0;
+	return NB_BITS(p & CENTRE_LARGE) + NB_BITS(p & CENTRE) +
+		   4 * (NB_BITS(cfn & CENTRE_LARGE) + NB_BITS(cfn & CENTRE));
+} // fin de occupationCentre
 
-	// parties : nombre de pièces
-	for (i = 0; i < 8; i++)
-		for (j = 0; j < 8; j++)
-		{
-			switch (conf->mat[i][j])
-			{
-			case 'p':
-				pionB++;
-				break;
-			case 'c':
-			case 'f':
-				cfB++;
-				break;
-			case 't':
-				tB++;
-				break;
-			case 'n':
-				nB++;
-				break;
+/* Nombre de directions (parmi les 8) où la première pièce rencontrée à partir du roi de 'coul'
+   est une pièce amie */
+int protectionRoi(struct config *conf, int coul)
+{
+	int r;
 
-			case -'p':
-				pionN++;
-				break;
-			case -'c':
-			case -'f':
-				cfN++;
-				break;
-			case -'t':
-				tN++;
-				break;
-			case -'n':
-				nN++;
-				break;
-			}
+	if (conf->pieces[coul][ROI] == 0)
+		return 0;
+	r = PREMIER_BIT(conf->pieces[coul][ROI]);
+	// les attaques d'une reine placée sur la case du roi s'arrêtent sur les premières pièces rencontrées
+	return NB_BITS((attFou(r, conf->occTout) | attTour(r, conf->occTout)) & conf->occ[coul]);
+} // fin de protectionRoi
+
+/* Nombre pondéré de pièces adverses menacées par le joueur 'coul' 
+   (pion:1  cavalier/fou:2  tour/reine:3  roi:6) */
+int menaces(struct config *conf, int coul)
+{
+	int adv = 1 - coul;
+	bitboard m = attaquesCouleur(conf, coul) & conf->occ[adv];
+
+	return NB_BITS(m) + NB_BITS(m & (conf->pieces[adv][CAVALIER] | conf->pieces[adv][FOU])) +
+		   2 * NB_BITS(m & (conf->pieces[adv][TOUR] | conf->pieces[adv][REINE])) +
+		   5 * NB_BITS(m & conf->pieces[adv][ROI]);
+} // fin de menaces
+
+/* Score de structure des pions de 'coul' : pions passés (bonus selon leur avance), 
+   pions doublés et isolés (malus), et bouclier de pions devant le roi resté sur ses 2 premières rangées */
+int structurePions(struct config *conf, int coul)
+{
+	int c, x, score = 0;
+	bitboard p = conf->pieces[coul][PION], q = conf->pieces[1 - coul][PION];
+	bitboard b, devant, col, voisines, bouclier;
+
+	for (b = p; b; b &= b - 1)
+	{
+		c = PREMIER_BIT(b);
+		x = LIGNE(c);
+		col = COL_A << COLONNE(c);
+		voisines = ((col << 1) & ~COL_A) | ((col >> 1) & ~COL_H);
+
+		// doublé : un autre pion ami devant lui sur sa colonne (compté une fois par pion en trop)
+		devant = rayons[(coul == BLANC ? 0 : 4)][c];
+		if (p & devant)
+			score -= 2;
+		// isolé : aucun pion ami sur les colonnes voisines
+		if ((p & voisines) == 0)
+			score -= 2;
+		// passé : aucun pion adverse devant lui sur sa colonne ni sur les colonnes voisines
+		devant |= ((devant << 1) & ~COL_A) | ((devant >> 1) & ~COL_H);
+		if ((q & devant) == 0)
+			score += (coul == BLANC ? x : 7 - x);
+	}
+
+	// bouclier : pions amis sur les 2 rangées devant le roi, dans sa colonne et les colonnes voisines
+	if (conf->pieces[coul][ROI])
+	{
+		c = PREMIER_BIT(conf->pieces[coul][ROI]);
+		x = LIGNE(c);
+		if (x == (coul == BLANC ? 0 : 7) || x == (coul == BLANC ? 1 : 6))
+		{
+			bouclier = attRoi[c] | BIT(c);
+			bouclier |= (coul == BLANC ? bouclier << 8 : bouclier >> 8);
+			bouclier &= (coul == BLANC ? ~0ULL << (8 * (x + 1)) : ~0ULL >> (8 * (8 - x)));
+			x = NB_BITS(p & bouclier);
+			score += 2 * (x > 3 ? 3 : x);
 		}
+	}
+
+	return score;
+
+} // fin de structurePions
+
+/* Scores de structure des pions des Blancs et des Noirs, pris dans la table des pions 
+   s'ils y sont déjà (ils ne dépendent que des pions et des rois) */
+void evalPions(struct config *conf, int score[2])
+{
+	struct entreePions *e = &tablePions[conf->clePions & (TAILLE_TABLE_PIONS - 1)];
+	bitboard d = e->donnee;
+
+	if ((e->verif ^ d) == conf->clePions)
+		nbPionsTrouves++;
+	else
+	{
+		nbPionsCalcules++;
+		d = (bitboard)(unsigned short)structurePions(conf, BLANC) |
+			((bitboard)(unsigned short)structurePions(conf, NOIR) << 16);
+		e->donnee = d;
+		e->verif = conf->clePions ^ d;
+	}
+	score[BLANC] = (short)(d & 0xFFFF);
+	score[NOIR] = (short)((d >> 16) & 0xFFFF);
+
+} // fin de evalPions
+
+/* cette estimation est basée uniquement sur le nombre de pièces */
+int estim1(struct config *conf)
+{
+
+	int ScrQte;
 
 	// Somme pondérée de pièces de chaque joueur.
 	// Les poids sont fixés comme suit: pion:2  cavalier/fou:6  tour:8  et  reine:20
 	// Le facteur 100/76 pour ne pas sortir de l'intervalle ]-100 , +100[
-	ScrQte = ((pionB * 2 + cfB * 6 + tB * 8 + nB * 20) - (pionN * 2 + cfN * 6 + tN * 8 + nN * 20)) * 100.0 / 76;
+	ScrQte = (materiel(conf, BLANC) - materiel(conf, NOIR)) * 100.0 / 76;
 
 	if (ScrQte > 95)
 		ScrQte = 95; // pour l'intervalle à
@@ -1023,104 +1902,18 @@ int estim1(struct config *conf)
 // estimation basée sur le nb de pieces, l'occupation, la défense du roi et les roques
 int estim2(struct config *conf)
 {
-	int i, j, a, b, stop, bns, ScrQte, ScrDisp, ScrDfs, ScrDivers, Score;
-	int pionB = 0, pionN = 0, cfB = 0, cfN = 0, tB = 0, tN = 0, nB = 0, nN = 0;
-	int occCentreB = 0, occCentreN = 0, protectRB = 0, protectRN = 0, divB = 0, divN = 0;
+	int ScrQte, ScrDisp, ScrDfs, ScrDivers, Score;
+	int divB = 0, divN = 0;
 
 	// parties : nombre de pièces et occupation du centre
-	for (i = 0; i < 8; i++)
-		for (j = 0; j < 8; j++)
-		{
-			bns = 0; // bonus pour l'occupation du centre de l'échiquier
-			if (i > 1 && i < 6 && j >= 0 && j <= 7)
-				bns = 1;
-			if (i > 2 && i < 5 && j >= 2 && j <= 5)
-				bns = 2;
-			switch (conf->mat[i][j])
-			{
-			case 'p':
-				pionB++;
-				occCentreB += bns;
-				break;
-			case 'c':
-			case 'f':
-				cfB++;
-				occCentreB += 4 * bns;
-				break;
-			case 't':
-				tB++;
-				break;
-			case 'n':
-				nB++;
-				occCentreB += 4 * bns;
-				break;
-
-			case -'p':
-				pionN++;
-				occCentreN += bns;
-				break;
-			case -'c':
-			case -'f':
-				cfN++;
-				occCentreN += 4 * bns;
-				break;
-			case -'t':
-				tN++;
-				break;
-			case -'n':
-				nN++;
-				occCentreN += 4 * bns;
-				break;
-			}
-		}
-
-	ScrQte = ((pionB * 2 + cfB * 6 + tB * 8 + nB * 20) - (pionN * 2 + cfN * 6 + tN * 8 + nN * 20));
+	ScrQte = materiel(conf, BLANC) - materiel(conf, NOIR);
 	// donc ScrQteMax ==> 76
 
-	ScrDisp = occCentreB - occCentreN;
+	ScrDisp = occupationCentre(conf, BLANC) - occupationCentre(conf, NOIR);
 	// donc ScrDispMax ==> 42
 
-	// partie : défense du roi B ...
-	for (i = 0; i < 8; i += 1)
-	{
-		// traitement des 8 directions paires et impaires
-		stop = 0;
-		a = conf->xrB + D[i][0];
-		b = conf->yrB + D[i][1];
-		while (!stop && a >= 0 && a <= 7 && b >= 0 && b <= 7)
-			if (conf->mat[a][b] != 0)
-				stop = 1;
-			else
-			{
-				a = a + D[i][0];
-				b = b + D[i][1];
-			}
-		if (stop)
-			if (conf->mat[a][b] > 0)
-				protectRB++;
-	} // for
-
-	// partie : défense du roi N ...
-	for (i = 0; i < 8; i += 1)
-	{
-		// traitement des 8 directions paires et impaires
-		stop = 0;
-		a = conf->xrN + D[i][0];
-		b = conf->yrN + D[i][1];
-		while (!stop && a >= 0 && a <= 7 && b >= 0 && b <= 7)
-			if (conf->mat[a][b] != 0)
-				stop = 1;
-			else
-			{
-				a = a + D[i][0];
-				b = b + D[i][1];
-			}
-		if (stop)
-			if (conf->mat[a][b] < 0)
-				protectRN++;
-	} // for
-
-	ScrDfs = protectRB - protectRN;
+	// partie : défense des rois B et N ...
+	ScrDfs = protectionRoi(conf, BLANC) - protectionRoi(conf, NOIR);
 	// donc ScrDfsMax ==> 8
 
 	// Partie : autres considérations ...
@@ -1157,46 +1950,10 @@ int estim2(struct config *conf)
 int estim3(struct config *conf)
 {
 
-	int i, j, ScrQte, Score;
-	int pionB = 0, pionN = 0, cfB = 0, cfN = 0, tB = 0, tN = 0, nB = 0, nN = 0;
+	int ScrQte, Score;
 
 	// parties : nombre de pièces
-	for (i = 0; i < 8; i++)
-		for (j = 0; j < 8; j++)
-		{
-			switch (conf->mat[i][j])
-			{
-			case 'p':
-				pionB++;
-				break;
-			case 'c':
-			case 'f':
-				cfB++;
-				break;
-			case 't':
-				tB++;
-				break;
-			case 'n':
-				nB++;
-				break;
-
-			case -'p':
-				pionN++;
-				break;
-			case -'c':
-			case -'f':
-				cfN++;
-				break;
-			case -'t':
-				tN++;
-				break;
-			case -'n':
-				nN++;
-				break;
-			}
-		}
-
-	ScrQte = ((pionB * 2 + cfB * 6 + tB * 8 + nB * 20) - (pionN * 2 + cfN * 6 + tN * 8 + nN * 20));
+	ScrQte = materiel(conf, BLANC) - materiel(conf, NOIR);
 	// donc ScrQteMax ==> 76
 
 	Score = (10 * ScrQte + rand() % 10) * 100.0 / (10 * 76 + 10);
@@ -1215,74 +1972,14 @@ int estim3(struct config *conf)
 int estim4(struct config *conf)
 {
 
-	int i, j, Score;
-	int pionB = 0, pionN = 0, cfB = 0, cfN = 0, tB = 0, tN = 0, nB = 0, nN = 0;
-	int npmB = 0, npmN = 0;
-
-	// parties : nombre de pièces
-	for (i = 0; i < 8; i++)
-		for (j = 0; j < 8; j++)
-		{
-			switch (conf->mat[i][j])
-			{
-			case 'p':
-				pionB++;
-				break;
-			case 'c':
-			case 'f':
-				cfB++;
-				break;
-			case 't':
-				tB++;
-				break;
-			case 'n':
-				nB++;
-				break;
-
-			case -'p':
-				pionN++;
-				break;
-			case -'c':
-			case -'f':
-				cfN++;
-				break;
-			case -'t':
-				tN++;
-				break;
-			case -'n':
-				nN++;
-				break;
-			}
-		}
+	int Score;
+	int npmB, npmN;
 
-	for (i = 0; i < 8; i++)
-		for (j = 0; j < 8; j++)
-		{
-			if (conf->mat[i][j] < 0 && caseMenaceePar(MAX, i, j, conf))
-			{
-				npmB++;
-				if (conf->mat[i][j] == -'c' || conf->mat[i][j] == -'f')
-					npmB++;
-				if (conf->mat[i][j] == -'t' || conf->mat[i][j] == -'n')
-					npmB += 2;
-				if (conf->mat[i][j] == -'r')
-					npmB += 5;
-			}
-			if (conf->mat[i][j] > 0 && caseMenaceePar(MIN, i, j, conf))
-			{
-				npmN++;
-				if (conf->mat[i][j] == 'c' || conf->mat[i][j] == 'f')
-					npmN++;
-				if (conf->mat[i][j] == 't' || conf->mat[i][j] == 'n')
-					npmN += 2;
-				if (conf->mat[i][j] == 'r')
-					npmN += 5;
-			}
-		}
+	// parties : nombre de pièces et pièces menacées
+	npmB = menaces(conf, BLANC);
+	npmN = menaces(conf, NOIR);
 
-	Score = (4 * ((pionB * 2 + cfB * 6 + tB * 8 + nB * 20) - (pionN * 2 + cfN * 6 + tN * 8 + nN * 20)) +
-			 (npmB - npmN)) *
-			100.0 / (4 * 76 + 31);
+	Score = (4 * (materiel(conf, BLANC) - materiel(conf, NOIR)) + (npmB - npmN)) * 100.0 / (4 * 76 + 31);
 
 	// pour les poids des pièces et le facteur multiplicatif voir commentaire dans estim1
 
@@ -1298,60 +1995,12 @@ int estim4(struct config *conf)
 // estimation basée sur le nb de pieces et l'occupation
 int estim5(struct config *conf)
 {
-	int i, j, a, b, stop, bns, ScrQte, ScrDisp, ScrDfs, ScrDivers, Score;
-	int pionB = 0, pionN = 0, cfB = 0, cfN = 0, tB = 0, tN = 0, nB = 0, nN = 0;
-	int occCentreB = 0, occCentreN = 0, protectRB = 0, protectRN = 0, divB = 0, divN = 0;
+	int ScrQte, ScrDisp, Score;
 
 	// parties : nombre de pièces et occupation du centre
-	for (i = 0; i < 8; i++)
-		for (j = 0; j < 8; j++)
-		{
-			bns = 0; // bonus pour l'occupation du centre de l'échiquier
-			if (i > 1 && i < 6 && j >= 0 && j <= 7)
-				bns = 1;
-			if (i > 2 && i < 5 && j >= 2 && j <= 5)
-				bns = 2;
-			switch (conf->mat[i][j])
-			{
-			case 'p':
-				pionB++;
-				occCentreB += bns;
-				break;
-			case 'c':
-			case 'f':
-				cfB++;
-				occCentreB += 4 * bns;
-				break;
-			case 't':
-				tB++;
-				break;
-			case 'n':
-				nB++;
-				occCentreB += 4 * bns;
-				break;
-
-			case -'p':
-				pionN++;
-				occCentreN += bns;
-				break;
-			case -'c':
-			case -'f':
-				cfN++;
-				occCentreN += 4 * bns;
-				break;
-			case -'t':
-				tN++;
-				break;
-			case -'n':
-				nN++;
-				occCentreN += 4 * bns;
-				break;
-			}
-		}
-
-	ScrQte = ((pionB * 2 + cfB * 6 + tB * 8 + nB * 20) - (pionN * 2 + cfN * 6 + tN * 8 + nN * 20));
+	ScrQte = materiel(conf, BLANC) - materiel(conf, NOIR);
 
-	ScrDisp = occCentreB - occCentreN;
+	ScrDisp = occupationCentre(conf, BLANC) - occupationCentre(conf, NOIR);
 
 	Score = (4 * ScrQte + ScrDisp) * 100.0 / (4 * 76 + 42);
 	// pour les poids des pièces et le facteur multiplicatif voir commentaire dans estim1
@@ -1382,190 +2031,51 @@ int estim6(struct config *conf)
 } // fin de estim6
 
 /* Une fonction d'estimation vide */
-int estim8(struct config *conf)
+int estim7(struct config *conf)
 {
-	// Mettez ici votre code ...
-	// 	...
-	// 	...
+	int ScrQte, PenaliteDispB, PenaliteDispN, PenaliteDisp, ScrAtt, ScrDfs, Score;
+	int pionB, pionN, cfB, cfN, tB, tN, nB, nN;
+	int occAttaqueB, occAttaqueN;
+	int piecegaucheB, piecedroiteB, piecegaucheN, piecedroiteN; //la dispersion des pieces sur l'échiquier
+	int npmB, npmN;
+	bitboard fnB, fnN, horsRoiB, horsRoiN;
+
+	// parties : nombre de pièces (les cavaliers ne comptent que dans la dispersion)
+	pionB = NB_BITS(conf->pieces[BLANC][PION]);
+	cfB = NB_BITS(conf->pieces[BLANC][FOU]);
+	tB = NB_BITS(conf->pieces[BLANC][TOUR]);
+	nB = NB_BITS(conf->pieces[BLANC][REINE]);
+	pionN = NB_BITS(conf->pieces[NOIR][PION]);
+	cfN = NB_BITS(conf->pieces[NOIR][FOU]);
+	tN = NB_BITS(conf->pieces[NOIR][TOUR]);
+	nN = NB_BITS(conf->pieces[NOIR][REINE]);
+
+	// bonus pour l'occupation d'attaque de l'échiquier (pions: 1 ou 2, fous et reines: 4 fois plus)
+	//   attaquant d'une piece blanche sur la ligne 4 ou 5 : 1, sur la ligne 6 ou 7 : 2
+	//   attaquant d'une piece noire sur la ligne 3 ou 2 : 1, sur la ligne 1 ou 0 : 2
+	fnB = conf->pieces[BLANC][FOU] | conf->pieces[BLANC][REINE];
+	fnN = conf->pieces[NOIR][FOU] | conf->pieces[NOIR][REINE];
+	occAttaqueB = NB_BITS(conf->pieces[BLANC][PION] & ATTAQUE_B1) + NB_BITS(conf->pieces[BLANC][PION] & ATTAQUE_B2) +
+				  4 * (NB_BITS(fnB & ATTAQUE_B1) + NB_BITS(fnB & ATTAQUE_B2));
+	occAttaqueN = NB_BITS(conf->pieces[NOIR][PION] & ATTAQUE_N1) + NB_BITS(conf->pieces[NOIR][PION] & ATTAQUE_N2) +
+				  4 * (NB_BITS(fnN & ATTAQUE_N1) + NB_BITS(fnN & ATTAQUE_N2));
+
+	// la partie gauche et la partie droite de l'échiquier pour calculer la dispersion (distribution) des pieces
+	horsRoiB = conf->occ[BLANC] & ~conf->pieces[BLANC][ROI];
+	horsRoiN = conf->occ[NOIR] & ~conf->pieces[NOIR][ROI];
+	piecegaucheB = NB_BITS(horsRoiB & GAUCHE);
+	piecedroiteB = NB_BITS(horsRoiB & DROITE);
+	piecegaucheN = NB_BITS(horsRoiN & GAUCHE);
+	piecedroiteN = NB_BITS(horsRoiN & DROITE);
 
-	// et remplacez la valeur retournée
-	return (rand() % 200) - 100;
+	//l'ajout de menacer à attaquer pour provoquer plus de dommage aux adversaires
+	npmB = menaces(conf, BLANC);
+	npmN = menaces(conf, NOIR);
 
-} // fin de estim7
+	ScrQte = (4 * ((pionB * 2 + cfB * 6 + tB * 8 + nB * 20) - (pionN * 2 + cfN * 6 + tN * 8 + nN * 20)) +
+			  (npmB - npmN));
 
-/* Une fonction d'estimation vide */
-int estim7(struct config *conf)
-{
-	int i, j, a, b, stop, bns, ScrQte, PenaliteDispB, PenaliteDispN, PenaliteDisp, ScrAtt, ScrDfs, ScrDivers, Score;
-	int pionB = 0, pionN = 0, cfB = 0, cfN = 0, tB = 0, tN = 0, nB = 0, nN = 0;
-	int occAttaqueB = 0, occAttaqueN = 0;
-	int piecegaucheB = 0, piecedroiteB = 0, piecegaucheN = 0, piecedroiteN = 0; //la dispersion des pieces sur l'échiquier
-	int protectRB = 0, protectRN = 0;											// protection du roi
-	int npmB = 0, npmN = 0;
-
-	for (i = 0; i < 8; i++)
-	{
-		//la partie gauche de l'échiquier pour calculer la dispersion (distribution )des pieces
-		for (j = 0; j < 4; j++)
-		{
-
-			bns = 0; // bonus pour l'occupation d'attaque de l'échiquier
-			if (i > 3 && i < 6)
-				bns = 1; //attaquant d'une piece blanche sur la ligne 4 ou 5
-			if (i > 5 && i < 8)
-				bns = 2; //attaquant d'une piece blanche sur la ligne 6 ou 7
-			switch (conf->mat[i][j])
-			{
-			case 'p':
-				pionB++;
-				occAttaqueB += bns;
-				piecegaucheB++;
-				break;
-			case 'c':
-				piecegaucheB++;
-				break;
-			case 'f':
-				cfB++;
-				occAttaqueB += 4 * bns;
-				piecegaucheB++;
-				break;
-			case 't':
-				tB++;
-				piecegaucheB++;
-				break;
-			case 'n':
-				nB++;
-				occAttaqueB += 4 * bns;
-				piecegaucheB++;
-				break;
-			}
-			bns = 0; // bonus pour l'occupation d'attaque de l'échiquier
-			if (i > 1 && i < 4)
-				bns = 1; //attaquant d'une piece noire sur la ligne 3 ou 2
-			if (i >= 0 && i < 2)
-				bns = 2; //attaquant d'une piece noire sur la ligne 1 ou 0
-			switch (conf->mat[i][j])
-			{
-			case -'p':
-				pionN++;
-				occAttaqueN += bns;
-				piecegaucheN++;
-				break;
-			case -'c':
-				piecegaucheN++;
-				break;
-			case -'f':
-				cfN++;
-				occAttaqueN += 4 * bns;
-				piecegaucheN++;
-				break;
-			case -'t':
-				tN++;
-				piecegaucheN++;
-				break;
-			case -'n':
-				nN++;
-				occAttaqueN += 4 * bns;
-				piecegaucheN++;
-				break;
-			}
-		}
-		//la partie droite de l'échiquier pour calculer la dispersion (distribution ) des pieces
-		for (j = 4; j < 8; j++)
-		{
-			bns = 0; // bonus pour l'occupation d'attaque de l'échiquier
-			if (i > 3 && i < 6)
-				bns = 1; //attaquant d'une piece blanche sur la ligne 4 ou 5
-			if (i > 5 && i < 8)
-				bns = 2; //attaquant d'une piece blanche sur la ligne 6 ou 7
-			switch (conf->mat[i][j])
-			{
-			case 'p':
-				pionB++;
-				occAttaqueB += bns;
-				piecedroiteB++;
-				break;
-			case 'c':
-				piecedroiteB++;
-				break;
-			case 'f':
-				cfB++;
-				occAttaqueB += 4 * bns;
-				piecedroiteB++;
-				break;
-			case 't':
-				tB++;
-				piecedroiteB++;
-				break;
-			case 'n':
-				nB++;
-				occAttaqueB += 4 * bns;
-				piecedroiteB++;
-				break;
-			}
-			bns = 0; // bonus pour l'occupation d'attaque de l'échiquier
-			if (i > 1 && i < 4)
-				bns = 1; //attaquant d'une piece noire sur la ligne 3 ou 2
-			if (i >= 0 && i < 2)
-				bns = 2; //attaquant d'une piece noire sur la ligne 1 ou 0
-			switch (conf->mat[i][j])
-			{
-			case -'p':
-				pionN++;
-				occAttaqueN += bns;
-				piecedroiteN++;
-				break;
-			case -'c':
-				piecedroiteN++;
-				break;
-			case -'f':
-				cfN++;
-				occAttaqueN += 4 * bns;
-				piecedroiteN++;
-				break;
-			case -'t':
-				tN++;
-				piecedroiteN++;
-				break;
-			case -'n':
-				nN++;
-				occAttaqueN += 4 * bns;
-				piecedroiteN++;
-				break;
-			}
-		}
-	}
-
-	//l'ajout de menacer à attaquer pour provoquer plus de dommage aux adversaires
-	for (i = 0; i < 8; i++)
-		for (j = 0; j < 8; j++)
-		{
-			if (conf->mat[i][j] < 0 && caseMenaceePar(MAX, i, j, conf))
-			{
-				npmB++;
-				if (conf->mat[i][j] == -'c' || conf->mat[i][j] == -'f')
-					npmB++;
-				if (conf->mat[i][j] == -'t' || conf->mat[i][j] == -'n')
-					npmB += 2;
-				if (conf->mat[i][j] == -'r')
-					npmB += 5;
-			}
-			if (conf->mat[i][j] > 0 && caseMenaceePar(MIN, i, j, conf))
-			{
-				npmN++;
-				if (conf->mat[i][j] == 'c' || conf->mat[i][j] == 'f')
-					npmN++;
-				if (conf->mat[i][j] == 't' || conf->mat[i][j] == 'n')
-					npmN += 2;
-				if (conf->mat[i][j] == 'r')
-					npmN += 5;
-			}
-		}
-
-	ScrQte = (4 * ((pionB * 2 + cfB * 6 + tB * 8 + nB * 20) - (pionN * 2 + cfN * 6 + tN * 8 + nN * 20)) +
-			  (npmB - npmN));
-
-	ScrAtt = occAttaqueB - occAttaqueN;
+	ScrAtt = occAttaqueB - occAttaqueN;
 
 	PenaliteDispB = piecedroiteB - piecegaucheB;
 	if (PenaliteDispB < 0)
@@ -1575,51 +2085,11 @@ int estim7(struct config *conf)
 		PenaliteDispN = -PenaliteDispN; //valeur propre pour la dispersion
 	PenaliteDisp = PenaliteDispB - PenaliteDispN;
 
-	Score = (4 * ScrQte + ScrAtt - 2 * PenaliteDisp) * 100.0 / (4 * 76 + 31 + 46 + 8 - 2 * 46);
 	// si on utilise seulement la dispersion pour prendre la décision on peut abondonner le roi en gardant l'equilibre entre
 	// la partie gauche et droite donc , on doit utiliser la fonction d'estimation (2) pour protéger le roi
 
-	// partie : défense du roi B ...
-	for (i = 0; i < 8; i += 1)
-	{
-		// traitement des 8 directions paires et impaires
-		stop = 0;
-		a = conf->xrB + D[i][0];
-		b = conf->yrB + D[i][1];
-		while (!stop && a >= 0 && a <= 7 && b >= 0 && b <= 7)
-			if (conf->mat[a][b] != 0)
-				stop = 1;
-			else
-			{
-				a = a + D[i][0];
-				b = b + D[i][1];
-			}
-		if (stop)
-			if (conf->mat[a][b] > 0)
-				protectRB++;
-	} // for
-
-	// partie : défense du roi N ...
-	for (i = 0; i < 8; i += 1)
-	{
-		// traitement des 8 directions paires et impaires
-		stop = 0;
-		a = conf->xrN + D[i][0];
-		b = conf->yrN + D[i][1];
-		while (!stop && a >= 0 && a <= 7 && b >= 0 && b <= 7)
-			if (conf->mat[a][b] != 0)
-				stop = 1;
-			else
-			{
-				a = a + D[i][0];
-				b = b + D[i][1];
-			}
-		if (stop)
-			if (conf->mat[a][b] < 0)
-				protectRN++;
-	} // for
-
-	ScrDfs = protectRB - protectRN;
+	// partie : défense des rois B et N ...
+	ScrDfs = protectionRoi(conf, BLANC) - protectionRoi(conf, NOIR);
 	// donc ScrDfsMax ==> 8
 
 	Score = (4 * ScrQte + ScrAtt - 2 * PenaliteDisp + ScrDfs) * 100.0 / (4 * 76 + 31 + 46 - 2 * 46);
@@ -1632,803 +2102,2869 @@ int estim7(struct config *conf)
 
 } // fin de estim7
 
-// ***********************************
-// Partie:  Génération des Successeurs
-// ***********************************
-
-/* Génère dans T les configurations obtenues à partir de conf lorsqu'un pion (a,b) va atteindre 
-   la limite de l'échiquier: pos (x,y)  */
-void transformPion(struct config *conf, int a, int b, int x, int y, struct config T[], int *n)
-{
-	int signe = +1;
-	if (conf->mat[a][b] < 0)
-		signe = -1;
-	copier(conf, &T[*n]);
-	T[*n].mat[a][b] = 0;
-	T[*n].mat[x][y] = signe * 'n'; // transformation en Reine
-	(*n)++;
-	copier(conf, &T[*n]);
-	T[*n].mat[a][b] = 0;
-	T[*n].mat[x][y] = signe * 'c'; // transformation en Cavalier
-	(*n)++;
-	copier(conf, &T[*n]);
-	T[*n].mat[a][b] = 0;
-	T[*n].mat[x][y] = signe * 'f'; // transformation en Fou
-	(*n)++;
-	copier(conf, &T[*n]);
-	T[*n].mat[a][b] = 0;
-	T[*n].mat[x][y] = signe * 't'; // transformation en Tour
-	(*n)++;
+// estimation basée sur le nb de pièces, l'occupation, la structure des pions et la défense du roi
+int estim8(struct config *conf)
+{
+	int ScrQte, ScrDisp, ScrPions, ScrDfs, Score;
+	int pions[2];
 
-} // fin de transformPion
+	// parties : nombre de pièces et occupation du centre
+	ScrQte = materiel(conf, BLANC) - materiel(conf, NOIR);
+	// donc ScrQteMax ==> 76
 
-// Vérifie si la case (x,y) est menacée par une des pièces du joueur 'mode'
-int caseMenaceePar(int mode, int x, int y, struct config *conf)
-{
-	int i, j, a, b, stop;
+	ScrDisp = occupationCentre(conf, BLANC) - occupationCentre(conf, NOIR);
+	// donc ScrDispMax ==> 42
 
-	// menace par le roi ...
-	for (i = 0; i < 8; i += 1)
-	{
-		// traitement des 8 directions paires et impaires
-		a = x + D[i][0];
-		b = y + D[i][1];
-		if (a >= 0 && a <= 7 && b >= 0 && b <= 7)
-			if (conf->mat[a][b] * mode == 'r')
-				return 1;
-	} // for
+	// partie : structure des pions (table des pions) ...
+	evalPions(conf, pions);
+	ScrPions = pions[BLANC] - pions[NOIR];
+	// donc ScrPionsMax ==> 30 environ (hors positions extrêmes)
 
-	// menace par cavalier ...
-	for (i = 0; i < 8; i++)
-		if (x + dC[i][0] <= 7 && x + dC[i][0] >= 0 && y + dC[i][1] <= 7 && y + dC[i][1] >= 0)
-			if (conf->mat[x + dC[i][0]][y + dC[i][1]] * mode == 'c')
-				return 1;
+	// partie : défense des rois B et N ...
+	ScrDfs = protectionRoi(conf, BLANC) - protectionRoi(conf, NOIR);
+	// donc ScrDfsMax ==> 8
 
-	// menace par pion ...
-	if ((x - mode) >= 0 && (x - mode) <= 7 && y > 0 && conf->mat[x - mode][y - 1] * mode == 'p')
-		return 1;
-	if ((x - mode) >= 0 && (x - mode) <= 7 && y < 7 && conf->mat[x - mode][y + 1] * mode == 'p')
-		return 1;
+	Score = (4 * ScrQte + ScrDisp + ScrPions + ScrDfs) * 100.0 / (4 * 76 + 42 + 30 + 8);
+	// pour les poids des pièces et le facteur multiplicatif voir commentaire dans estim1
 
-	// menace par fou, tour ou reine ...
-	for (i = 0; i < 8; i += 1)
-	{
-		// traitement des 8 directions paires et impaires
-		stop = 0;
-		a = x + D[i][0];
-		b = y + D[i][1];
-		while (!stop && a >= 0 && a <= 7 && b >= 0 && b <= 7)
-			if (conf->mat[a][b] != 0)
-				stop = 1;
-			else
-			{
-				a = a + D[i][0];
-				b = b + D[i][1];
-			}
-		if (stop)
-		{
-			if (conf->mat[a][b] * mode == 'f' && i % 2 != 0)
-				return 1;
-			if (conf->mat[a][b] * mode == 't' && i % 2 == 0)
-				return 1;
-			if (conf->mat[a][b] * mode == 'n')
-				return 1;
-		}
-	} // for
+	if (Score > 98)
+		Score = 98;
+	if (Score < -98)
+		Score = -98;
 
-	// sinon, aucune menace ...
-	return 0;
+	return Score;
 
-} // fin de caseMenaceePar
+} // fin de estim8
 
-/* Génere dans T tous les coups possibles de la pièce (de couleur N) se trouvant à la pos x,y */
-void deplacementsN(struct config *conf, int x, int y, struct config T[], int *n)
+/* Estimation réellement utilisée par Est[numFctEst] (celle choisie par estim6 suivant 
+   num_coup, avec l'ordre du tableau Est rempli dans main) */
+int estimEffective(int numFctEst)
+{
+	if (Est[numFctEst] != estim6)
+		return numFctEst;
+	if (num_coup < 25)
+		return 1; // estim2
+	if (num_coup < 35)
+		return 4; // estim5
+	return 3;	  // estim4
+
+} // fin de estimEffective
+
+/* Estimation de conf par Est[numFctEst], en passant par le cache des estimations
+   (sauf pour estim3, qui n'est pas déterministe) */
+int estimer(struct config *conf, int numFctEst)
 {
-	int i, j, a, b, stop;
+	bitboard cle = conf->cle ^ zobEst[estimEffective(numFctEst)];
+	bitboard e = cacheEst[cle & (TAILLE_CACHE_EST - 1)];
+	int v;
 
-	switch (conf->mat[x][y])
+	// une finale des tables a une valeur exacte
+	if (valeurFinale(conf, &v))
+		return v;
+
+	// estim3 tire une nouvelle perturbation aléatoire à chaque appel : sa valeur n'est pas gardée
+	if (Est[numFctEst] == estim3)
+		return estim3(conf);
+
+	if ((e & ~VAL_CACHE_EST) == (cle & ~VAL_CACHE_EST))
 	{
-	// mvmt PION ...
-	case -'p':
-		if (x > 0 && conf->mat[x - 1][y] == 0)
-		{
-			// avance d'une case
-			copier(conf, &T[*n]);
-			T[*n].mat[x][y] = 0;
-			T[*n].mat[x - 1][y] = -'p';
-			(*n)++;
-			if (x == 1)
-				transformPion(conf, x, y, x - 1, y, T, n);
-		}
-		if (x == 6 && conf->mat[5][y] == 0 && conf->mat[4][y] == 0)
-		{
-			// avance de 2 cases
-			copier(conf, &T[*n]);
-			T[*n].mat[6][y] = 0;
-			T[*n].mat[4][y] = -'p';
-			(*n)++;
-		}
-		if (x > 0 && y > 0 && conf->mat[x - 1][y - 1] > 0)
-		{
-			// attaque à droite (en descendant)
-			copier(conf, &T[*n]);
-			T[*n].mat[x][y] = 0;
-			T[*n].mat[x - 1][y - 1] = -'p';
-			// cas où le roi adverse est pris...
-			if (T[*n].xrB == x - 1 && T[*n].yrB == y - 1)
-			{
-				T[*n].xrB = -1;
-				T[*n].yrB = -1;
-			}
+		nbEstTrouvees++;
+		return (short)(e & VAL_CACHE_EST);
+	}
 
-			(*n)++;
-			if (x == 1)
-				transformPion(conf, x, y, x - 1, y - 1, T, n);
-		}
-		if (x > 0 && y < 7 && conf->mat[x - 1][y + 1] > 0)
-		{
-			// attaque à gauche (en descendant)
-			copier(conf, &T[*n]);
-			T[*n].mat[x][y] = 0;
-			T[*n].mat[x - 1][y + 1] = -'p';
-			// cas où le roi adverse est pris...
-			if (T[*n].xrB == x - 1 && T[*n].yrB == y + 1)
-			{
-				T[*n].xrB = -1;
-				T[*n].yrB = -1;
-			}
+	nbEstCalculees++;
+	v = Est[numFctEst](conf);
+	cacheEst[cle & (TAILLE_CACHE_EST - 1)] = (cle & ~VAL_CACHE_EST) | (unsigned short)v;
+	return v;
 
-			(*n)++;
-			if (x == 1)
-				transformPion(conf, x, y, x - 1, y + 1, T, n);
-		}
-		break;
+} // fin de estimer
 
-	// mvmt CAVALIER ...
-	case -'c':
-		for (i = 0; i < 8; i++)
-			if (x + dC[i][0] <= 7 && x + dC[i][0] >= 0 && y + dC[i][1] <= 7 && y + dC[i][1] >= 0)
-				if (conf->mat[x + dC[i][0]][y + dC[i][1]] >= 0)
-				{
-					copier(conf, &T[*n]);
-					T[*n].mat[x][y] = 0;
-					T[*n].mat[x + dC[i][0]][y + dC[i][1]] = -'c';
-					// cas où le roi adverse est pris...
-					if (T[*n].xrB == x + dC[i][0] && T[*n].yrB == y + dC[i][1])
-					{
-						T[*n].xrB = -1;
-						T[*n].yrB = -1;
-					}
+/* Reporte dans les totaux les compteurs du cache des estimations et de la table des pions
+   du thread appelant */
+void reporterStatistiques()
+{
+	__sync_fetch_and_add(&nbEstTrouveesTous, nbEstTrouvees);
+	__sync_fetch_and_add(&nbEstCalculeesTous, nbEstCalculees);
+	__sync_fetch_and_add(&nbPionsTrouvesTous, nbPionsTrouves);
+	__sync_fetch_and_add(&nbPionsCalculesTous, nbPionsCalcules);
+	nbEstTrouvees = nbEstCalculees = nbPionsTrouves = nbPionsCalcules = 0;
 
-					(*n)++;
-				}
-		break;
+} // fin de reporterStatistiques
 
-	// mvmt FOU ...
-	case -'f':
-		for (i = 1; i < 8; i += 2)
-		{
-			// traitement des directions impaires (1, 3, 5 et 7)
-			stop = 0;
-			a = x + D[i][0];
-			b = y + D[i][1];
-			while (!stop && a >= 0 && a <= 7 && b >= 0 && b <= 7)
+// ***************************************
+// Partie:  Bitboards et tables d'attaques
+// ***************************************
+
+/* Initialise les tables des pièces glissantes à partir des vecteurs de direction D
+   (les tables du cavalier, du roi et des pions sont constantes) */
+void initBitboards()
+{
+	int x, y, i, a, b, c;
+	bitboard r;
+
+	for (x = 0; x < 8; x++)
+		for (y = 0; y < 8; y++)
+		{
+			c = CASE(x, y);
+			for (i = 0; i < 8; i++)
 			{
-				if (conf->mat[a][b] < 0)
-					stop = 1;
-				else
+				// rayon dans la direction i ...
+				a = x + D[i][0];
+				b = y + D[i][1];
+				while (a >= 0 && a <= 7 && b >= 0 && b <= 7)
 				{
-					copier(conf, &T[*n]);
-					T[*n].mat[x][y] = 0;
-					if (T[*n].mat[a][b] > 0)
-						stop = 1;
-					T[*n].mat[a][b] = -'f';
-					// cas où le roi adverse est pris...
-					if (T[*n].xrB == a && T[*n].yrB == b)
-					{
-						T[*n].xrB = -1;
-						T[*n].yrB = -1;
-					}
-
-					(*n)++;
+					rayons[i][c] |= BIT(CASE(a, b));
 					a = a + D[i][0];
 					b = b + D[i][1];
 				}
-			} // while
-		}	 // for
-		break;
+			}
+		}
 
-	// mvmt TOUR ...
-	case -'t':
-		for (i = 0; i < 8; i += 2)
-		{
-			// traitement des directions paires (0, 2, 4 et 6)
-			stop = 0;
-			a = x + D[i][0];
-			b = y + D[i][1];
-			while (!stop && a >= 0 && a <= 7 && b >= 0 && b <= 7)
+	// cases entre c et chaque case a de ses rayons : le rayon privé de a et de ce qui est au-delà
+	for (c = 0; c < 64; c++)
+		for (i = 0; i < 8; i++)
+			for (r = rayons[i][c]; r; r &= r - 1)
 			{
-				if (conf->mat[a][b] < 0)
-					stop = 1;
-				else
-				{
-					copier(conf, &T[*n]);
-					T[*n].mat[x][y] = 0;
-					if (T[*n].mat[a][b] > 0)
-						stop = 1;
-					T[*n].mat[a][b] = -'t';
-					// cas où le roi adverse est pris...
-					if (T[*n].xrB == a && T[*n].yrB == b)
-					{
-						T[*n].xrB = -1;
-						T[*n].yrB = -1;
-					}
+				a = PREMIER_BIT(r);
+				entre[c][a] = rayons[i][c] & ~rayons[i][a] & ~BIT(a);
+			}
 
-					if (conf->roqueN != 'e' && conf->roqueN != 'n')
-					{
-						if (x == 7 && y == 0 && conf->roqueN != 'p')
-							// le grand roque ne sera plus possible
-							T[*n].roqueN = 'g';
-						else if (x == 7 && y == 0)
-							// ni le grand roque ni le petit roque ne seront possibles
-							T[*n].roqueN = 'n';
-
-						if (x == 7 && y == 7 && conf->roqueN != 'g')
-							// le petit roque ne sera plus possible
-							T[*n].roqueN = 'p';
-						else if (x == 7 && y == 7)
-							// ni le grand roque ni le petit roque ne seront possibles
-							T[*n].roqueN = 'n';
-					}
+	// pièces glissantes ...
+#if defined(__x86_64__) && defined(__GNUC__)
+	avecPext = __builtin_cpu_supports("bmi2");
+#endif
+	initMagiques(magieFou, tableFou, 1);
+	initMagiques(magieTour, tableTour, 0);
 
-					(*n)++;
-					a = a + D[i][0];
-					b = b + D[i][1];
-				}
-			} // while
-		}	 // for
-		break;
+	initZobrist();
 
-	// mvmt REINE ...
-	case -'n':
-		for (i = 0; i < 8; i += 1)
-		{
-			// traitement des 8 directions paires et impaires
-			stop = 0;
-			a = x + D[i][0];
-			b = y + D[i][1];
-			while (!stop && a >= 0 && a <= 7 && b >= 0 && b <= 7)
-			{
-				if (conf->mat[a][b] < 0)
-					stop = 1;
-				else
-				{
-					copier(conf, &T[*n]);
-					T[*n].mat[x][y] = 0;
-					if (T[*n].mat[a][b] > 0)
-						stop = 1;
-					T[*n].mat[a][b] = -'n';
-					// cas où le roi adverse est pris...
-					if (T[*n].xrB == a && T[*n].yrB == b)
-					{
-						T[*n].xrB = -1;
-						T[*n].yrB = -1;
-					}
+} // fin de initBitboards
 
-					(*n)++;
-					a = a + D[i][0];
-					b = b + D[i][1];
-				}
-			} // while
-		}	 // for
-		break;
+#if defined(__x86_64__) && defined(__GNUC__)
+/* Index PEXT : les bits de occ sélectionnés par masque, regroupés en bits de poids faible */
+__attribute__((target("bmi2"))) static inline bitboard indicePext(bitboard occ, bitboard masque)
+{
+	return _pext_u64(occ, masque);
+} // fin de indicePext
+#else
+static inline bitboard indicePext(bitboard occ, bitboard masque)
+{
+	return 0; // jamais appelée (avecPext reste à 0)
+} // fin de indicePext
+#endif
 
-	// mvmt ROI ...
-	case -'r':
-		// vérifier possibilité de faire un roque ...
-		if (conf->roqueN != 'n' && conf->roqueN != 'e')
+/* Index dans la table d'attaques de m pour l'occupation occ */
+static inline unsigned indiceMagie(struct magie *m, bitboard occ)
+{
+	if (avecPext)
+		return indicePext(occ, m->masque);
+	return ((occ & m->masque) * m->magique) >> m->decal;
+} // fin de indiceMagie
+
+/* Générateur pseudo-aléatoire (xorshift) pour la recherche des nombres magiques */
+static bitboard aleaMagie()
+{
+	static bitboard graine = 0x9E3779B97F4A7C15ULL; // graine fixe : mêmes tables à chaque exécution
+	graine ^= graine >> 12;
+	graine ^= graine << 25;
+	graine ^= graine >> 27;
+	return graine * 2685821657736338717ULL;
+} // fin de aleaMagie
+
+/* Construit les tables d'attaques du fou (dirDeb == 1, directions impaires) ou de la tour
+   (dirDeb == 0, directions paires) : pour chaque case on énumère tous les sous-ensembles
+   du masque, puis on cherche un nombre magique qui les range sans collision destructive */
+void initMagiques(struct magie mag[64], bitboard *table, int dirDeb)
+{
+	static bitboard occ[4096], att[4096];
+	static int essai[4096];
+	int c, i, n, k, tentative, ok;
+	unsigned idx;
+	bitboard sub, r;
+
+	for (c = 0; c < 64; c++)
+	{
+		// masque : les rayons sans leur case au bord de l'échiquier
+		mag[c].masque = 0;
+		for (i = dirDeb; i < 8; i += 2)
 		{
-			if (conf->roqueN != 'g' && conf->mat[7][1] == 0 && conf->mat[7][2] == 0 && conf->mat[7][3] == 0)
-				if (!caseMenaceePar(MAX, 7, 1, conf) && !caseMenaceePar(MAX, 7, 2, conf) &&
-					!caseMenaceePar(MAX, 7, 3, conf) && !caseMenaceePar(MAX, 7, 4, conf))
-				{
-					// Faire un grand roque ...
-					copier(conf, &T[*n]);
-					T[*n].mat[7][4] = 0;
-					T[*n].mat[7][0] = 0;
-					T[*n].mat[7][2] = -'r';
-					T[*n].xrN = 7;
-					T[*n].yrN = 2;
-					T[*n].mat[7][3] = -'t';
-					// aucun roque ne sera plus possible à partir de cette config
-					T[*n].roqueN = 'e';
-					(*n)++;
-				}
-			if (conf->roqueN != 'p' && conf->mat[7][5] == 0 && conf->mat[7][6] == 0)
-				if (!caseMenaceePar(MAX, 7, 4, conf) && !caseMenaceePar(MAX, 7, 5, conf) &&
-					!caseMenaceePar(MAX, 7, 6, conf))
-				{
-					// Faire un petit roque ...
-					copier(conf, &T[*n]);
-					T[*n].mat[7][4] = 0;
-					T[*n].mat[7][7] = 0;
-					T[*n].mat[7][6] = -'r';
-					T[*n].xrN = 7;
-					T[*n].yrN = 6;
-					T[*n].mat[7][5] = -'t';
-					// aucun roque ne sera plus possible à partir de cette config
-					T[*n].roqueN = 'e';
-					(*n)++;
-				}
+			r = rayons[i][c];
+			if (r)
+				r &= ~BIT(8 * D[i][0] + D[i][1] > 0 ? DERNIER_BIT(r) : PREMIER_BIT(r));
+			mag[c].masque |= r;
 		}
+		mag[c].decal = 64 - NB_BITS(mag[c].masque);
+		mag[c].att = table;
 
-		// vérifier les autres mouvements du roi ...
-		for (i = 0; i < 8; i += 1)
+		// tous les sous-ensembles du masque (Carry-Rippler) et les attaques correspondantes
+		n = 0;
+		sub = 0;
+		do
+		{
+			occ[n] = sub;
+			att[n] = 0;
+			for (i = dirDeb; i < 8; i += 2)
+				att[n] |= attRayon(i, c, sub);
+			n++;
+			sub = (sub - mag[c].masque) & mag[c].masque;
+		} while (sub);
+
+		if (avecPext)
+		{
+			for (k = 0; k < n; k++)
+				table[indicePext(occ[k], mag[c].masque)] = att[k];
+		}
+		else
 		{
-			// traitement des 8 directions paires et impaires
-			a = x + D[i][0];
-			b = y + D[i][1];
-			if (a >= 0 && a <= 7 && b >= 0 && b <= 7)
-				if (conf->mat[a][b] >= 0)
+			// recherche d'un nombre magique (peu de bits à 1) sans collision destructive
+			memset(essai, 0, sizeof(essai));
+			for (tentative = 1, ok = 0; !ok; tentative++)
+			{
+				mag[c].magique = aleaMagie() & aleaMagie() & aleaMagie();
+				if (NB_BITS((mag[c].masque * mag[c].magique) >> 56) < 6)
+					continue;
+				for (k = 0, ok = 1; ok && k < n; k++)
 				{
-					copier(conf, &T[*n]);
-					T[*n].mat[x][y] = 0;
-					T[*n].mat[a][b] = -'r';
-					T[*n].xrN = a;
-					T[*n].yrN = b;
-					// cas où le roi adverse est pris...
-					if (T[*n].xrB == a && T[*n].yrB == b)
+					idx = ((occ[k] * mag[c].magique) >> mag[c].decal);
+					if (essai[idx] != tentative)
 					{
-						T[*n].xrB = -1;
-						T[*n].yrB = -1;
+						essai[idx] = tentative;
+						table[idx] = att[k];
 					}
-					// aucun roque ne sera plus possible à partir de cette config
-					T[*n].roqueN = 'n';
-					(*n)++;
+					else if (table[idx] != att[k])
+						ok = 0;
 				}
-		} // for
-		break;
+			}
+		}
+		table += n;
 	}
 
-} // fin de deplacementsN
+} // fin de initMagiques
 
-/* Génere dans T tous les coups possibles de la pièce (de couleur B) se trouvant à la pos x,y */
-void deplacementsB(struct config *conf, int x, int y, struct config T[], int *n)
+/* Cases attaquées depuis la case c dans la direction i de D, 
+   le rayon s'arrêtant sur la première case occupée de occ */
+bitboard attRayon(int i, int c, bitboard occ)
 {
-	int i, j, a, b, stop;
+	bitboard att = rayons[i][c];
+	bitboard bloq = att & occ;
 
-	switch (conf->mat[x][y])
+	if (bloq)
 	{
-	// mvmt PION ...
-	case 'p':
-		if (x < 7 && conf->mat[x + 1][y] == 0)
+		// la case bloquante est la plus proche de c : le bit le plus faible si la direction
+		// fait croître les numéros de cases, le plus fort sinon
+		if (8 * D[i][0] + D[i][1] > 0)
+			att ^= rayons[i][PREMIER_BIT(bloq)];
+		else
+			att ^= rayons[i][DERNIER_BIT(bloq)];
+	}
+	return att;
+
+} // fin de attRayon
+
+/* Cases attaquées par un fou en c (une lecture dans la table magique) */
+bitboard attFou(int c, bitboard occ)
+{
+	return magieFou[c].att[indiceMagie(&magieFou[c], occ)];
+} // fin de attFou
+
+/* Cases attaquées par une tour en c (une lecture dans la table magique) */
+bitboard attTour(int c, bitboard occ)
+{
+	return magieTour[c].att[indiceMagie(&magieTour[c], occ)];
+} // fin de attTour
+
+/* Ensemble des cases attaquées par les pièces de la couleur coul */
+bitboard attaquesCouleur(struct config *conf, int coul)
+{
+	bitboard att = 0, b;
+
+	for (b = conf->pieces[coul][PION]; b; b &= b - 1)
+		att |= attPion[coul][PREMIER_BIT(b)];
+	for (b = conf->pieces[coul][CAVALIER]; b; b &= b - 1)
+		att |= attCavalier[PREMIER_BIT(b)];
+	for (b = conf->pieces[coul][FOU] | conf->pieces[coul][REINE]; b; b &= b - 1)
+		att |= attFou(PREMIER_BIT(b), conf->occTout);
+	for (b = conf->pieces[coul][TOUR] | conf->pieces[coul][REINE]; b; b &= b - 1)
+		att |= attTour(PREMIER_BIT(b), conf->occTout);
+	for (b = conf->pieces[coul][ROI]; b; b &= b - 1)
+		att |= attRoi[PREMIER_BIT(b)];
+
+	return att;
+
+} // fin de attaquesCouleur
+
+/* Type de la pièce de couleur coul se trouvant en c (-1 si aucune) */
+int typeEn(struct config *conf, int coul, int c)
+{
+	if (!(conf->occ[coul] & BIT(c)))
+		return -1;
+	return conf->cases[c] - 1;
+
+} // fin de typeEn
+
+/* Pose une pièce sur la case c */
+void poserPiece(struct config *conf, int coul, int type, int c)
+{
+	conf->pieces[coul][type] |= BIT(c);
+	conf->occ[coul] |= BIT(c);
+	conf->occTout |= BIT(c);
+	conf->cases[c] = type + 1;
+	conf->cle ^= zobPiece[coul][type][c];
+	if (type == PION || type == ROI)
+		conf->clePions ^= zobPiece[coul][type][c];
+} // fin de poserPiece
+
+/* Enlève une pièce de la case c */
+void enleverPiece(struct config *conf, int coul, int type, int c)
+{
+	conf->pieces[coul][type] &= ~BIT(c);
+	conf->occ[coul] &= ~BIT(c);
+	conf->occTout &= ~BIT(c);
+	conf->cases[c] = 0;
+	conf->cle ^= zobPiece[coul][type][c];
+	if (type == PION || type == ROI)
+		conf->clePions ^= zobPiece[coul][type][c];
+} // fin de enleverPiece
+
+/* Nouvel indicateur de roque lorsque le grand (cote == 'g') ou le petit (cote == 'p') roque
+   ne sera plus possible (tour déplacée ou prise dans son coin d'origine) */
+char perteRoque(char roque, char cote)
+{
+	if (roque == 'e' || roque == 'n' || roque == cote)
+		return roque;
+	if (roque == 'r')
+		return cote;
+	// l'autre roque n'était déjà plus possible
+	return 'n';
+
+} // fin de perteRoque
+
+/* Joue le coup c sur conf (déplacement avec prise et transformation éventuelles, ou roque) */
+void jouerCoup(struct config *conf, Coup c, struct annul *u)
+{
+	int coul, adv, type, x;
+	char *roque, *roqueAdv;
+
+	u->pris = -1;
+	u->xrB = conf->xrB;
+	u->yrB = conf->yrB;
+	u->xrN = conf->xrN;
+	u->yrN = conf->yrN;
+	u->roqueB = conf->roqueB;
+	u->roqueN = conf->roqueN;
+	u->cle = conf->cle;
+	u->demiCoups = conf->demiCoups;
+	conf->demiCoups++;
+
+	// les indicateurs de roque et le trait changent de clé (les pièces sont mises à jour
+	// par poserPiece et enleverPiece)
+	conf->cle ^= zobRoque[BLANC][(int)conf->roqueB] ^ zobRoque[NOIR][(int)conf->roqueN] ^ zobTrait;
+
+	coul = (conf->occ[BLANC] & BIT(DE(c)) ? BLANC : NOIR);
+	adv = 1 - coul;
+	roque = (coul == BLANC ? &conf->roqueB : &conf->roqueN);
+	roqueAdv = (coul == BLANC ? &conf->roqueN : &conf->roqueB);
+
+	if (EST_ROQUE(c))
+	{
+		x = 7 * coul; // ligne des pièces de coul : 0 pour B et 7 pour N
+		enleverPiece(conf, coul, ROI, CASE(x, 4));
+		poserPiece(conf, coul, ROI, VERS(c));
+		if (DRAP(c) & P_ROQUE)
 		{
-			// avance d'une case
-			copier(conf, &T[*n]);
-			T[*n].mat[x][y] = 0;
-			T[*n].mat[x + 1][y] = 'p';
-			(*n)++;
-			if (x == 6)
-				transformPion(conf, x, y, x + 1, y, T, n);
-		}
-		if (x == 1 && conf->mat[2][y] == 0 && conf->mat[3][y] == 0)
-		{
-			// avance de 2 cases
-			copier(conf, &T[*n]);
-			T[*n].mat[1][y] = 0;
-			T[*n].mat[3][y] = 'p';
-			(*n)++;
-		}
-		if (x < 7 && y > 0 && conf->mat[x + 1][y - 1] < 0)
-		{
-			// attaque à gauche (en montant)
-			copier(conf, &T[*n]);
-			T[*n].mat[x][y] = 0;
-			T[*n].mat[x + 1][y - 1] = 'p';
+			enleverPiece(conf, coul, TOUR, CASE(x, 7));
+			poserPiece(conf, coul, TOUR, CASE(x, 5));
+		}
+		else
+		{
+			enleverPiece(conf, coul, TOUR, CASE(x, 0));
+			poserPiece(conf, coul, TOUR, CASE(x, 3));
+		}
+		if (coul == BLANC)
+		{
+			conf->xrB = x;
+			conf->yrB = COLONNE(VERS(c));
+		}
+		else
+		{
+			conf->xrN = x;
+			conf->yrN = COLONNE(VERS(c));
+		}
+		// aucun roque ne sera plus possible à partir de cette config
+		*roque = 'e';
+	}
+	else
+	{
+		// prise éventuelle d'une pièce adverse ...
+		if (EST_PRISE(c))
+		{
+			conf->demiCoups = 0; // coup irréversible
+			u->pris = typeEn(conf, adv, VERS(c));
+			enleverPiece(conf, adv, u->pris, VERS(c));
 			// cas où le roi adverse est pris...
-			if (T[*n].xrN == x + 1 && T[*n].yrN == y - 1)
+			if (u->pris == ROI && adv == BLANC)
 			{
-				T[*n].xrN = -1;
-				T[*n].yrN = -1;
+				conf->xrB = -1;
+				conf->yrB = -1;
 			}
-
-			(*n)++;
-			if (x == 6)
-				transformPion(conf, x, y, x + 1, y - 1, T, n);
+			if (u->pris == ROI && adv == NOIR)
+			{
+				conf->xrN = -1;
+				conf->yrN = -1;
+			}
+			// une tour prise dans son coin d'origine ne pourra plus servir à un roque
+			if (u->pris == TOUR && VERS(c) == CASE(7 * adv, 0))
+				*roqueAdv = perteRoque(*roqueAdv, 'g');
+			if (u->pris == TOUR && VERS(c) == CASE(7 * adv, 7))
+				*roqueAdv = perteRoque(*roqueAdv, 'p');
 		}
-		if (x < 7 && y < 7 && conf->mat[x + 1][y + 1] < 0)
+
+		type = typeEn(conf, coul, DE(c));
+		enleverPiece(conf, coul, type, DE(c));
+		poserPiece(conf, coul, (EST_PROMO(c) ? PIECE_PROMO(c) : type), VERS(c));
+		if (type == PION)
+			conf->demiCoups = 0; // coup irréversible
+
+		if (type == ROI)
 		{
-			// attaque à droite (en montant)
-			copier(conf, &T[*n]);
-			T[*n].mat[x][y] = 0;
-			T[*n].mat[x + 1][y + 1] = 'p';
-			// cas où le roi adverse est pris...
-			if (T[*n].xrN == x + 1 && T[*n].yrN == y + 1)
+			if (coul == BLANC)
 			{
-				T[*n].xrN = -1;
-				T[*n].yrN = -1;
+				conf->xrB = LIGNE(VERS(c));
+				conf->yrB = COLONNE(VERS(c));
 			}
-
-			(*n)++;
-			if (x == 6)
-				transformPion(conf, x, y, x + 1, y + 1, T, n);
+			else
+			{
+				conf->xrN = LIGNE(VERS(c));
+				conf->yrN = COLONNE(VERS(c));
+			}
+			// aucun roque ne sera plus possible à partir de cette config
+			*roque = 'n';
 		}
-		break;
 
-	// mvmt CAVALIER ...
-	case 'c':
-		for (i = 0; i < 8; i++)
-			if (x + dC[i][0] <= 7 && x + dC[i][0] >= 0 && y + dC[i][1] <= 7 && y + dC[i][1] >= 0)
-				if (conf->mat[x + dC[i][0]][y + dC[i][1]] <= 0)
-				{
-					copier(conf, &T[*n]);
-					T[*n].mat[x][y] = 0;
-					T[*n].mat[x + dC[i][0]][y + dC[i][1]] = 'c';
-					// cas où le roi adverse est pris...
-					if (T[*n].xrN == x + dC[i][0] && T[*n].yrN == y + dC[i][1])
-					{
-						T[*n].xrN = -1;
-						T[*n].yrN = -1;
-					}
+		if (type == TOUR && DE(c) == CASE(7 * coul, 0))
+			// le grand roque ne sera plus possible
+			*roque = perteRoque(*roque, 'g');
+		if (type == TOUR && DE(c) == CASE(7 * coul, 7))
+			// le petit roque ne sera plus possible
+			*roque = perteRoque(*roque, 'p');
+	}
 
-					(*n)++;
-				}
-		break;
+	conf->cle ^= zobRoque[BLANC][(int)conf->roqueB] ^ zobRoque[NOIR][(int)conf->roqueN];
 
-	// mvmt FOU ...
-	case 'f':
-		for (i = 1; i < 8; i += 2)
-		{
-			// traitement des directions impaires (1, 3, 5 et 7)
-			stop = 0;
-			a = x + D[i][0];
-			b = y + D[i][1];
-			while (!stop && a >= 0 && a <= 7 && b >= 0 && b <= 7)
-			{
-				if (conf->mat[a][b] > 0)
-					stop = 1;
-				else
-				{
-					copier(conf, &T[*n]);
-					T[*n].mat[x][y] = 0;
-					if (T[*n].mat[a][b] < 0)
-						stop = 1;
-					T[*n].mat[a][b] = 'f';
-					// cas où le roi adverse est pris...
-					if (T[*n].xrN == a && T[*n].yrN == b)
-					{
-						T[*n].xrN = -1;
-						T[*n].yrN = -1;
-					}
-					(*n)++;
-					a = a + D[i][0];
-					b = b + D[i][1];
-				}
-			} // while
-		}	 // for
-		break;
+#ifdef VERIF_CLE
+	// mode mise au point : la clé tenue à jour doit être celle recalculée entièrement
+	if (conf->cle != calculerCle(conf, (coul == BLANC ? MIN : MAX)))
+	{
+		printf("Clé de Zobrist incorrecte après le coup %d -> %d\n", DE(c), VERS(c));
+		exit(1);
+	}
+#endif
 
-	// mvmt TOUR ...
-	case 't':
-		for (i = 0; i < 8; i += 2)
-		{
-			// traitement des directions paires (0, 2, 4 et 6)
-			stop = 0;
-			a = x + D[i][0];
-			b = y + D[i][1];
-			while (!stop && a >= 0 && a <= 7 && b >= 0 && b <= 7)
-			{
-				if (conf->mat[a][b] > 0)
-					stop = 1;
-				else
-				{
-					copier(conf, &T[*n]);
-					T[*n].mat[x][y] = 0;
-					if (T[*n].mat[a][b] < 0)
-						stop = 1;
-					T[*n].mat[a][b] = 't';
-					// cas où le roi adverse est pris...
-					if (T[*n].xrN == a && T[*n].yrN == b)
-					{
-						T[*n].xrN = -1;
-						T[*n].yrN = -1;
-					}
-					if (conf->roqueB != 'e' && conf->roqueB != 'n')
-					{
-						if (x == 0 && y == 0 && conf->roqueB != 'p')
-							// le grand roque ne sera plus possible
-							T[*n].roqueB = 'g';
-						else if (x == 0 && y == 0)
-							// ni le grand roque ni le petit roque ne seront possibles
-							T[*n].roqueB = 'n';
-						if (x == 0 && y == 7 && conf->roqueB != 'g')
-							// le petit roque ne sera plus possible
-							T[*n].roqueB = 'p';
-						else if (x == 0 && y == 7)
-							// ni le grand roque ni le petit roque ne seront possibles
-							T[*n].roqueB = 'n';
-					}
+} // fin de jouerCoup
+
+/* Annule le coup c joué sur conf par jouerCoup */
+void dejouerCoup(struct config *conf, Coup c, struct annul *u)
+{
+	int coul, type, x;
+
+	coul = (conf->occ[BLANC] & BIT(VERS(c)) ? BLANC : NOIR);
+
+	if (EST_ROQUE(c))
+	{
+		x = 7 * coul;
+		enleverPiece(conf, coul, ROI, VERS(c));
+		poserPiece(conf, coul, ROI, CASE(x, 4));
+		if (DRAP(c) & P_ROQUE)
+		{
+			enleverPiece(conf, coul, TOUR, CASE(x, 5));
+			poserPiece(conf, coul, TOUR, CASE(x, 7));
+		}
+		else
+		{
+			enleverPiece(conf, coul, TOUR, CASE(x, 3));
+			poserPiece(conf, coul, TOUR, CASE(x, 0));
+		}
+	}
+	else
+	{
+		// la pièce revient à sa case de départ (redevenant un pion si elle a été transformée)
+		type = typeEn(conf, coul, VERS(c));
+		enleverPiece(conf, coul, type, VERS(c));
+		poserPiece(conf, coul, (EST_PROMO(c) ? PION : type), DE(c));
+		if (u->pris != -1)
+			poserPiece(conf, 1 - coul, u->pris, VERS(c));
+	}
+
+	conf->xrB = u->xrB;
+	conf->yrB = u->yrB;
+	conf->xrN = u->xrN;
+	conf->yrN = u->yrN;
+	conf->roqueB = u->roqueB;
+	conf->roqueN = u->roqueN;
+	conf->cle = u->cle;
+	conf->demiCoups = u->demiCoups;
+
+} // fin de dejouerCoup
+
+// ***********************************
+// Partie:  Génération des Successeurs
+// ***********************************
+
+/* Ajoute le coup c à la fin de la liste L */
+void ajouterCoup(struct listeCoups *L, Coup c)
+{
+	L->c[L->n] = c;
+	L->val[L->n] = 0;
+	L->n++;
+} // fin de ajouterCoup
+
+/* Génère dans L les coups obtenus lorsqu'un pion de la case de va atteindre 
+   la limite de l'échiquier en vers */
+void transformPion(int de, int vers, int prise, struct listeCoups *L)
+{
+	ajouterCoup(L, COUP(de, vers, PROMO | prise | (REINE - CAVALIER)));	// transformation en Reine
+	ajouterCoup(L, COUP(de, vers, PROMO | prise | (CAVALIER - CAVALIER))); // transformation en Cavalier
+	ajouterCoup(L, COUP(de, vers, PROMO | prise | (FOU - CAVALIER)));		// transformation en Fou
+	ajouterCoup(L, COUP(de, vers, PROMO | prise | (TOUR - CAVALIER)));		// transformation en Tour
+
+} // fin de transformPion
+
+// Vérifie si la case (x,y) est menacée par une des pièces du joueur 'mode'
+int caseMenaceePar(int mode, int x, int y, struct config *conf)
+{
+	int c = CASE(x, y);
+	int coul = COULEUR(mode);
+
+	// menace par cavalier, roi ou pion (un pion de coul menace c s'il se trouve
+	// sur une case attaquée par un pion adverse placé en c) ...
+	if ((attCavalier[c] & conf->pieces[coul][CAVALIER]) || (attRoi[c] & conf->pieces[coul][ROI]) ||
+		(attPion[1 - coul][c] & conf->pieces[coul][PION]))
+		return 1;
+
+	// menace par fou, tour ou reine ...
+	if (attFou(c, conf->occTout) & (conf->pieces[coul][FOU] | conf->pieces[coul][REINE]))
+		return 1;
+	if (attTour(c, conf->occTout) & (conf->pieces[coul][TOUR] | conf->pieces[coul][REINE]))
+		return 1;
+
+	// sinon, aucune menace ...
+	return 0;
+
+} // fin de caseMenaceePar
+
+/* Pièces de la couleur coul attaquant la case c (avec l'occupation occ pour les pièces glissantes) */
+bitboard attaquants(struct config *conf, int c, int coul, bitboard occ)
+{
+	return (attCavalier[c] & conf->pieces[coul][CAVALIER]) |
+		   (attRoi[c] & conf->pieces[coul][ROI]) |
+		   (attPion[1 - coul][c] & conf->pieces[coul][PION]) |
+		   (attFou(c, occ) & (conf->pieces[coul][FOU] | conf->pieces[coul][REINE])) |
+		   (attTour(c, occ) & (conf->pieces[coul][TOUR] | conf->pieces[coul][REINE]));
+
+} // fin de attaquants
+
+/* Teste si le roi de coul est attaqué */
+int enEchec(struct config *conf, int coul)
+{
+	return conf->pieces[coul][ROI] &&
+		   attaquants(conf, PREMIER_BIT(conf->pieces[coul][ROI]), 1 - coul, conf->occTout) != 0;
+
+} // fin de enEchec
+
+/* Génere dans L les coups de la pièce de couleur coul et de type type se trouvant en c
+   vers les cases de permis (plus les roques possibles) */
+void deplacements(struct config *conf, int coul, int type, int c, bitboard permis, struct listeCoups *L)
+{
+	int x = LIGNE(c);
+	int ligne = 7 * coul;				 // ligne des pièces de coul : 0 pour B et 7 pour N
+	int av = (coul == BLANC ? +8 : -8); // avance d'une case pour un pion de coul
+	bitboard cibles = 0;
+
+	switch (type)
+	{
+	// mvmt PION ...
+	case PION:
+		if (x != 7 - ligne && !(conf->occTout & BIT(c + av)))
+		{
+			// avance d'une case
+			if (permis & BIT(c + av))
+			{
+				ajouterCoup(L, COUP(c, c + av, 0));
+				if (x == 7 - ligne - (coul == BLANC ? 1 : -1))
+					transformPion(c, c + av, 0, L);
+			}
+			if (x == ligne + (coul == BLANC ? 1 : -1) && !(conf->occTout & BIT(c + 2 * av)) &&
+				(permis & BIT(c + 2 * av)))
+				// avance de 2 cases
+				ajouterCoup(L, COUP(c, c + 2 * av, 0));
+		}
+		// attaques à gauche et à droite
+		for (cibles = attPion[coul][c] & conf->occ[1 - coul] & permis; cibles; cibles &= cibles - 1)
+		{
+			ajouterCoup(L, COUP(c, PREMIER_BIT(cibles), PRISE));
+			if (x == 7 - ligne - (coul == BLANC ? 1 : -1))
+				transformPion(c, PREMIER_BIT(cibles), PRISE, L);
+		}
+		return;
+
+	// mvmt CAVALIER ...
+	case CAVALIER:
+		cibles = attCavalier[c];
+		break;
+
+	// mvmt FOU ...
+	case FOU:
+		cibles = attFou(c, conf->occTout);
+		break;
+
+	// mvmt TOUR ...
+	case TOUR:
+		cibles = attTour(c, conf->occTout);
+		break;
+
+	// mvmt REINE ...
+	case REINE:
+		cibles = attFou(c, conf->occTout) | attTour(c, conf->occTout);
+		break;
+
+	// mvmt ROI ...
+	case ROI:
+		cibles = attRoi[c];
+		break;
+	}
+
+	// les autres mouvements : vers les cases permises vides ou occupées par l'adversaire
+	for (cibles &= ~conf->occ[coul] & permis; cibles; cibles &= cibles - 1)
+		ajouterCoup(L, COUP(c, PREMIER_BIT(cibles), (conf->occ[1 - coul] & BIT(PREMIER_BIT(cibles)) ? PRISE : 0)));
+
+} // fin de deplacements
+
+/* Génère dans L les roques possibles de coul (le roi et la tour étant à leurs places d'origine) */
+void roques(struct config *conf, int coul, bitboard cibles, struct listeCoups *L)
+{
+	int ligne = 7 * coul;
+	int c = CASE(ligne, 4);
+	int modeAdv = (coul == BLANC ? MIN : MAX);
+	char roque = (coul == BLANC ? conf->roqueB : conf->roqueN);
+
+	if (roque == 'n' || roque == 'e' || !(conf->pieces[coul][ROI] & BIT(c)))
+		return;
+
+	if (roque != 'g' && (cibles & BIT(CASE(ligne, 2))) && (conf->pieces[coul][TOUR] & BIT(CASE(ligne, 0))) &&
+		!(conf->occTout & (BIT(CASE(ligne, 1)) | BIT(CASE(ligne, 2)) | BIT(CASE(ligne, 3)))))
+		if (!caseMenaceePar(modeAdv, ligne, 1, conf) && !caseMenaceePar(modeAdv, ligne, 2, conf) &&
+			!caseMenaceePar(modeAdv, ligne, 3, conf) && !caseMenaceePar(modeAdv, ligne, 4, conf))
+		{
+			// Faire un grand roque ...
+			ajouterCoup(L, COUP(c, CASE(ligne, 2), G_ROQUE));
+		}
+	if (roque != 'p' && (cibles & BIT(CASE(ligne, 6))) && (conf->pieces[coul][TOUR] & BIT(CASE(ligne, 7))) &&
+		!(conf->occTout & (BIT(CASE(ligne, 5)) | BIT(CASE(ligne, 6)))))
+		if (!caseMenaceePar(modeAdv, ligne, 4, conf) && !caseMenaceePar(modeAdv, ligne, 5, conf) &&
+			!caseMenaceePar(modeAdv, ligne, 6, conf))
+		{
+			// Faire un petit roque ...
+			ajouterCoup(L, COUP(c, CASE(ligne, 6), P_ROQUE));
+		}
+
+} // fin de roques
+
+/* Génère dans L les coups légaux du joueur mode à partir de conf */
+void generer_coups(struct config *conf, int mode, struct listeCoups *L)
+{
+	generer_coups_vers(conf, mode, ~0ULL, L);
+} // fin de generer_coups
+
+/* Génère dans L les coups légaux du joueur mode à partir de conf, vers les cases de cibles */
+void generer_coups_vers(struct config *conf, int mode, bitboard cibles, struct listeCoups *L)
+{
+	int type, r, c, p;
+	int coul = COULEUR(mode), adv = 1 - coul;
+	bitboard b, e, echecs, cloues, permis, sur;
+	bitboard clouage[64]; // pour une pièce clouée : les cases où elle peut aller
+
+	L->n = 0;
+	r = PREMIER_BIT(conf->pieces[coul][ROI]);
+
+	// pièces adverses donnant échec au roi ...
+	echecs = attaquants(conf, r, adv, conf->occTout);
+
+	// pièces clouées : seule pièce entre le roi et un fou, une tour ou une reine adverse alignée,
+	// elle ne peut se déplacer qu'entre les deux ou prendre la pièce qui la cloue
+	cloues = 0;
+	b = (attFou(r, conf->occ[adv]) & (conf->pieces[adv][FOU] | conf->pieces[adv][REINE])) |
+		(attTour(r, conf->occ[adv]) & (conf->pieces[adv][TOUR] | conf->pieces[adv][REINE]));
+	for (; b; b &= b - 1)
+	{
+		p = PREMIER_BIT(b);
+		e = entre[r][p] & conf->occTout;
+		if (e && !(e & (e - 1)))
+		{
+			cloues |= e;
+			clouage[PREMIER_BIT(e)] = entre[r][p] | BIT(p);
+		}
+	}
+
+	// en échec simple, les autres pièces doivent prendre la pièce qui donne échec ou s'interposer ;
+	// en échec double, seul le roi peut bouger
+	if (echecs == 0)
+		permis = ~0ULL;
+	else if (!(echecs & (echecs - 1)))
+		permis = echecs | entre[r][PREMIER_BIT(echecs)];
+	else
+		permis = 0;
+	permis &= cibles;
+
+	// parcourir les pièces du joueur 'mode' type par type (sauf le roi) ...
+	if (permis)
+		for (type = PION; type < ROI; type++)
+			for (b = conf->pieces[coul][type]; b; b &= b - 1)
+			{
+				c = PREMIER_BIT(b);
+				deplacements(conf, coul, type, c, (cloues & BIT(c) ? permis & clouage[c] : permis), L);
+			}
+
+	// le roi : vers les cases non attaquées une fois qu'il a quitté sa case
+	// (un rayon qui le traverse reste dangereux)
+	sur = 0;
+	for (b = attRoi[r] & ~conf->occ[coul] & cibles; b; b &= b - 1)
+		if (!attaquants(conf, PREMIER_BIT(b), adv, conf->occTout ^ BIT(r)))
+			sur |= BIT(PREMIER_BIT(b));
+	roques(conf, coul, cibles, L);
+	deplacements(conf, coul, ROI, r, sur, L);
+
+} // fin de generer_coups_vers
+
+/* Teste si c fait partie des coups légaux de mode (seuls les coups vers la case d'arrivée 
+   de c sont générés) */
+int coupLegal(struct config *conf, int mode, Coup c)
+{
+	int i;
+	struct listeCoups L;
+
+	if (!(conf->occ[COULEUR(mode)] & BIT(DE(c))))
+		return 0;
+	generer_coups_vers(conf, mode, BIT(VERS(c)), &L);
+	for (i = 0; i < L.n; i++)
+		if (L.c[i] == c)
+			return 1;
+	return 0;
+
+} // fin de coupLegal
+
+// ***********************************
+// Partie:  Table de transposition
+// ***********************************
+
+/* Générateur pseudo-aléatoire (splitmix64) des clés de Zobrist, avec sa propre graine 
+   pour que les clés soient les mêmes sur toutes les machines */
+static bitboard aleaZobrist()
+{
+	static bitboard graine = 0x3243F6A8885A308DULL;
+	bitboard z = (graine += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+} // fin de aleaZobrist
+
+/* Tire les clés de Zobrist */
+void initZobrist()
+{
+	int coul, type, c, i;
+	char *r;
+
+	for (coul = BLANC; coul <= NOIR; coul++)
+	{
+		for (type = PION; type <= ROI; type++)
+			for (c = 0; c < 64; c++)
+				zobPiece[coul][type][c] = aleaZobrist();
+		for (r = "rgpne"; *r; r++)
+			zobRoque[coul][(int)*r] = aleaZobrist();
+	}
+	zobTrait = aleaZobrist();
+	for (i = 0; i < 10; i++)
+		zobEst[i] = aleaZobrist();
+
+} // fin de initZobrist
+
+/* Clé de Zobrist de conf calculée à partir de toutes ses pièces */
+bitboard calculerCle(struct config *conf, int mode)
+{
+	int coul, type;
+	bitboard b, cle = zobRoque[BLANC][(int)conf->roqueB] ^ zobRoque[NOIR][(int)conf->roqueN];
+
+	for (coul = BLANC; coul <= NOIR; coul++)
+		for (type = PION; type <= ROI; type++)
+			for (b = conf->pieces[coul][type]; b; b &= b - 1)
+				cle ^= zobPiece[coul][type][PREMIER_BIT(b)];
+	if (mode == MIN)
+		cle ^= zobTrait;
+	return cle;
+
+} // fin de calculerCle
+
+/* Alloue la table de transposition (puissance de 2 d'entrées tenant dans mo Mo) */
+void initTT(int mo)
+{
+	bitboard taille = (bitboard)(mo > 0 ? mo : 1) * 1024 * 1024 / sizeof(struct entreeTT);
+
+	while (taille & (taille - 1))
+		taille &= taille - 1;
+	free(tableTT);
+	tableTT = calloc(taille, sizeof(struct entreeTT));
+	masqueTT = taille - 1;
+
+} // fin de initTT
+
+/* Cherche cle dans la table de transposition */
+int sonderTT(bitboard cle, int prof, int alpha, int beta, int *score, Coup *coup)
+{
+	struct entreeTT *e;
+	bitboard d;
+	int v, borne;
+
+	*coup = COUP_NUL;
+	if (tableTT == NULL)
+		return 0;
+
+	e = &tableTT[cle & masqueTT];
+	d = e->donnee;
+	if ((e->verif ^ d) != cle)
+		return 0;
+
+	*coup = (Coup)(d & 0xFFFF);
+	if ((int)((d >> 32) & 0xFF) < prof)
+		return 0;
+
+	// la valeur rendue par minmax_ab est la vraie valeur ramenée dans [alpha, beta]
+	v = (short)((d >> 16) & 0xFFFF);
+	borne = (d >> 40) & 3;
+	if (borne == BORNE_EXACTE)
+	{
+		*score = (v < alpha ? alpha : (v > beta ? beta : v));
+		return 1;
+	}
+	if (borne == BORNE_INF && v >= beta)
+	{
+		*score = beta;
+		return 1;
+	}
+	if (borne == BORNE_SUP && v <= alpha)
+	{
+		*score = alpha;
+		return 1;
+	}
+	return 0;
+
+} // fin de sonderTT
+
+/* Range une valeur dans la table de transposition (une entrée d'une autre position est 
+   toujours remplacée, celle de la même position seulement par une recherche aussi profonde) */
+void stockerTT(bitboard cle, int prof, int score, int borne, Coup coup)
+{
+	struct entreeTT *e;
+	bitboard d;
+
+	// les bornes infinies de la fenêtre initiale ne sont pas des valeurs à garder
+	if (tableTT == NULL || score <= -INFINI / 2 || score >= INFINI / 2)
+		return;
+
+	e = &tableTT[cle & masqueTT];
+	d = e->donnee;
+	if ((e->verif ^ d) == cle)
+	{
+		if ((int)((d >> 32) & 0xFF) > prof)
+			return;
+		if (coup == COUP_NUL)
+			coup = (Coup)(d & 0xFFFF); // garder le meilleur coup déjà connu
+	}
+
+	d = (bitboard)coup | ((bitboard)(unsigned short)score << 16) | ((bitboard)prof << 32) |
+		((bitboard)borne << 40);
+	e->donnee = d;
+	e->verif = cle ^ d;
+
+} // fin de stockerTT
+
+// *********************************
+// Partie:  Fichier cache des analyses
+// *********************************
+
+/* Valeur de contrôle de l'en-tête : change si les clés de Zobrist changent */
+bitboard controleCache()
+{
+	return zobTrait ^ zobPiece[BLANC][PION][8] ^ zobRoque[NOIR]['r'] ^ zobEst[0];
+} // fin de controleCache
+
+/* Teste si le fichier cache projeté a le bon format */
+int enteteValide(struct enteteCache *e)
+{
+	return strcmp(e->signature, "ECHECS") == 0 && e->version == VERSION_CACHE &&
+		   e->nbEntrees == TAILLE_CACHE_DISQUE && e->controle == controleCache();
+} // fin de enteteValide
+
+/* Projette en mémoire le fichier cache s'il a la taille attendue (enteteCache, NULL sinon) */
+int projeterCache(size_t taille)
+{
+	struct stat st;
+	void *m;
+
+	enteteCache = NULL;
+	if (fstat(fdCache, &st) != 0 || st.st_size != (off_t)taille)
+		return 0;
+	m = mmap(NULL, taille, PROT_READ | PROT_WRITE, MAP_SHARED, fdCache, 0);
+	if (m == MAP_FAILED)
+		return 0;
+	enteteCache = (struct enteteCache *)m;
+	return 1;
+} // fin de projeterCache
+
+/* Ouvre et projette en mémoire le fichier cache nomf.
+   Chaque processus qui l'utilise garde un verrou partagé ; seul un fichier absent, d'une autre
+   version ou d'une autre taille est (ré)initialisé, sous verrou exclusif. Les entrées sont 
+   ensuite lues et écrites sans verrou, comme celles de la table de transposition */
+int ouvrirCache(char *nomf)
+{
+	size_t taille = sizeof(struct enteteCache) + TAILLE_CACHE_DISQUE * sizeof(struct entreeTT);
+	int essai;
+
+	fdCache = open(nomf, O_RDWR | O_CREAT, 0644);
+	if (fdCache < 0)
+		return 0;
+
+	// 1er essai sous verrou partagé ; si le fichier n'est pas au bon format, 2e essai sous verrou
+	// exclusif (un autre processus a pu l'initialiser entre temps) puis initialisation
+	for (essai = 0; essai < 2; essai++)
+	{
+		flock(fdCache, (essai == 0 ? LOCK_SH : LOCK_EX));
+		if (projeterCache(taille) && enteteValide(enteteCache))
+			break;
+		if (enteteCache != NULL)
+			munmap(enteteCache, taille);
+		enteteCache = NULL;
+	}
+
+	if (enteteCache == NULL)
+	{
+		if (ftruncate(fdCache, 0) != 0 || ftruncate(fdCache, taille) != 0 || !projeterCache(taille))
+		{
+			close(fdCache); // libère aussi le verrou
+			fdCache = -1;
+			return 0;
+		}
+		strcpy(enteteCache->signature, "ECHECS");
+		enteteCache->version = VERSION_CACHE;
+		enteteCache->nbEntrees = TAILLE_CACHE_DISQUE;
+		enteteCache->controle = controleCache();
+	}
+	flock(fdCache, LOCK_SH);
+
+	tableCache = (struct entreeTT *)(enteteCache + 1);
+	return 1;
+
+} // fin de ouvrirCache
+
+/* Écrit les entrées modifiées sur disque et ferme le fichier cache (libérant le verrou) */
+void fermerCache()
+{
+	size_t taille = sizeof(struct enteteCache) + TAILLE_CACHE_DISQUE * sizeof(struct entreeTT);
+
+	if (enteteCache == NULL)
+		return;
+	msync(enteteCache, taille, MS_SYNC);
+	munmap(enteteCache, taille);
+	close(fdCache);
+	enteteCache = NULL;
+	tableCache = NULL;
+	fdCache = -1;
+
+} // fin de fermerCache
+
+/* Clé d'une analyse de racine : position, joueur, estimation utilisée et largeur */
+bitboard cleCache(struct config *conf, int mode, int largeur, int numFctEst)
+{
+	bitboard cle = conf->cle ^ zobEst[estimEffective(numFctEst)];
+
+	if (mode == MIN)
+		cle = ~cle;
+	return cle ^ ((bitboard)largeur * 0x9E3779B97F4A7C15ULL);
+} // fin de cleCache
+
+/* Cherche l'analyse de la racine conf dans le fichier cache */
+int sonderCache(struct config *conf, int mode, int prof, int largeur, int numFctEst, int *score, Coup *coup)
+{
+	bitboard cle, d;
+	struct entreeTT *e;
+
+	if (tableCache == NULL)
+		return 0;
+	cle = cleCache(conf, mode, largeur, numFctEst);
+	e = &tableCache[cle & (TAILLE_CACHE_DISQUE - 1)];
+	d = e->donnee;
+	if ((e->verif ^ d) != cle || (int)((d >> 32) & 0xFF) < prof)
+		return 0;
+
+	*coup = (Coup)(d & 0xFFFF);
+	*score = (short)((d >> 16) & 0xFFFF);
+	return coupLegal(conf, mode, *coup);
+
+} // fin de sonderCache
+
+/* Range l'analyse de la racine conf dans le fichier cache (sauf si elle y est déjà plus profonde) */
+void rangerCache(struct config *conf, int mode, int prof, int largeur, int numFctEst, int score, Coup coup)
+{
+	bitboard cle, d;
+	struct entreeTT *e;
+
+	if (tableCache == NULL)
+		return;
+	cle = cleCache(conf, mode, largeur, numFctEst);
+	e = &tableCache[cle & (TAILLE_CACHE_DISQUE - 1)];
+	d = e->donnee;
+	if ((e->verif ^ d) == cle && (int)((d >> 32) & 0xFF) > prof)
+		return;
+
+	d = (bitboard)coup | ((bitboard)(unsigned short)score << 16) | ((bitboard)prof << 32) |
+		((bitboard)BORNE_EXACTE << 40);
+	e->donnee = d;
+	e->verif = cle ^ d;
+
+} // fin de rangerCache
+
+// ******************************
+// Partie:  MinMax avec AlphaBeta
+// ******************************
+
+/* Tri des coups de L suivant leurs estimations (tri par insertion, stable) :
+   ordre décroissant pour MAX et croissant pour MIN */
+void trierCoups(struct listeCoups *L, int mode)
+{
+	int i, j, v;
+	Coup c;
+
+	for (i = 1; i < L->n; i++)
+	{
+		c = L->c[i];
+		v = L->val[i];
+		for (j = i - 1; j >= 0 && (mode == MAX ? L->val[j] < v : L->val[j] > v); j--)
+		{
+			L->c[j + 1] = L->c[j];
+			L->val[j + 1] = L->val[j];
+		}
+		L->c[j + 1] = c;
+		L->val[j + 1] = v;
+	}
+
+} // fin de trierCoups
+
+/* Prépare la sélection des coups de mode dans s */
+void initSelecteur(struct selecteur *s, int mode, Coup coupHache, Coup *tueurs, int largeur)
+{
+	s->mode = mode;
+	s->coupHache = coupHache;
+	s->tueurs[0] = tueurs[0];
+	s->tueurs[1] = tueurs[1];
+	s->i = 0;
+	s->n = largeur;
+	s->etape = ETAPE_HACHE;
+
+} // fin de initSelecteur
+
+/* Prochain coup du sélecteur s (COUP_NUL si tous les coups ont été rendus) */
+Coup coupSuivant(struct config *conf, struct selecteur *s)
+{
+	int i, m, coul = COULEUR(s->mode);
+	Coup c;
+
+	// largeur d'exploration atteinte
+	if (s->n == 0)
+		return COUP_NUL;
+	s->n--;
+
+	switch (s->etape)
+	{
+	case ETAPE_HACHE:
+		s->etape = ETAPE_G_PRISES;
+		if (s->coupHache != COUP_NUL && coupLegal(conf, s->mode, s->coupHache))
+			return s->coupHache;
+		s->coupHache = COUP_NUL;
+		ENCHAINER; // puis ...
+
+	case ETAPE_G_PRISES:
+		generer_coups_vers(conf, s->mode, conf->occ[1 - coul], &s->L);
+		for (i = 0; i < s->L.n; i++)
+			s->L.val[i] = 8 * conf->cases[VERS(s->L.c[i])] - conf->cases[DE(s->L.c[i])];
+		s->i = 0;
+		s->etape = ETAPE_PRISES;
+		ENCHAINER; // puis ...
+
+	case ETAPE_PRISES:
+		while (s->i < s->L.n)
+		{
+			// amener en position i la meilleure des prises restantes
+			m = s->i;
+			for (i = s->i + 1; i < s->L.n; i++)
+				if (s->L.val[i] > s->L.val[m])
+					m = i;
+			c = s->L.c[m];
+			s->L.c[m] = s->L.c[s->i];
+			s->L.val[m] = s->L.val[s->i];
+			s->L.c[s->i] = c;
+			s->i++;
+			if (c != s->coupHache)
+				return c;
+		}
+		s->i = 0;
+		s->etape = ETAPE_TUEURS;
+		ENCHAINER; // puis ...
+
+	case ETAPE_TUEURS:
+		// un tueur d'une autre position n'y est pas forcément possible (ni calme)
+		while (s->i < 2)
+		{
+			c = s->tueurs[s->i++];
+			if (c != COUP_NUL && c != s->coupHache && !(conf->occTout & BIT(VERS(c))) &&
+				coupLegal(conf, s->mode, c))
+				return c;
+			s->tueurs[s->i - 1] = COUP_NUL;
+		}
+		s->etape = ETAPE_G_CALMES;
+		ENCHAINER; // puis ...
+
+	case ETAPE_G_CALMES:
+		generer_coups_vers(conf, s->mode, ~conf->occTout, &s->L);
+		for (i = 0; i < s->L.n; i++)
+			s->L.val[i] = histoCoupes[coul][DE(s->L.c[i])][VERS(s->L.c[i])];
+		s->i = 0;
+		s->etape = ETAPE_CALMES;
+		ENCHAINER; // puis ...
+
+	case ETAPE_CALMES:
+		while (s->i < s->L.n)
+		{
+			// amener en position i le coup restant de plus fort historique
+			m = s->i;
+			for (i = s->i + 1; i < s->L.n; i++)
+				if (s->L.val[i] > s->L.val[m])
+					m = i;
+			c = s->L.c[m];
+			s->L.c[m] = s->L.c[s->i];
+			s->L.val[m] = s->L.val[s->i];
+			s->L.c[s->i] = c;
+			s->i++;
+			if (c != s->coupHache && c != s->tueurs[0] && c != s->tueurs[1])
+				return c;
+		}
+		s->etape = ETAPE_FIN;
+	}
+
+	return COUP_NUL;
+
+} // fin de coupSuivant
+
+/* Le coup devient le 1er tueur de la profondeur courante (l'ancien 1er passant 2e), et son
+   historique augmente avec le carré de la hauteur du sous-arbre qu'il a coupé */
+void noterCoupe(int coul, Coup c, int niv)
+{
+	Coup *t = tueurs[nbHistorique];
+
+	if (t[0] != c)
+	{
+		t[1] = t[0];
+		t[0] = c;
+	}
+	histoCoupes[coul][DE(c)][VERS(c)] += niv * niv;
+	if (histoCoupes[coul][DE(c)][VERS(c)] > 1000000)
+		attenuerHistoCoupes();
+
+} // fin de noterCoupe
+
+/* Divise par 2 tout l'historique des coupes */
+void attenuerHistoCoupes()
+{
+	int de, vers;
+
+	for (de = 0; de < 64; de++)
+		for (vers = 0; vers < 64; vers++)
+		{
+			histoCoupes[BLANC][de][vers] /= 2;
+			histoCoupes[NOIR][de][vers] /= 2;
+		}
+
+} // fin de attenuerHistoCoupes
+
+/* MinMax avec élagage alpha-beta :
+ Evalue la configuration 'conf' du joueur 'mode' en descendant de 'niv' niveaux.
+ Le paramètre 'niv' est decrémenté à chaque niveau (appel récursif).
+ 'alpha' et 'beta' représentent les bornes initiales de l'intervalle d'intérêt 
+ (pour pouvoir effectuer les coupes alpha et bêta).
+ 'largeur' représente le nombre max d'alternatives à explorer en profondeur à chaque niveau.
+ Si 'largeur == +INFINI' toutes les alternatives seront prises en compte 
+ (c'est le comportement par défaut).
+ 'numFctEst' est le numéro de la fonction d'estimation à utiliser lorsqu'on arrive à la
+ frontière d'exploration (c-a-d 'niv' atteint 0)
+*/
+int minmax_ab(struct config *conf, int mode, int niv, int alpha, int beta, int largeur, int numFctEst)
+{
+	int score, score2, nbFils, coul, echec, r;
+	Coup c, meilleur;
+	bitboard cle;
+	struct selecteur s;
+	struct annul u;
+
+	// budget du coup épuisé : la recherche est abandonnée (sa valeur sera ignorée)
+	if (arretRecherche || ((++nbNoeuds & 1023) == 0 && budgetEpuise()))
+		return 0;
+
+	if (feuille(conf, &score))
+		return score;
+
+	// répétition d'une position de la partie ou du chemin de recherche, ou règle des 50 coups
+	if (partieNulle(conf, 1))
+		return 0;
+
+	// finale de peu de pièces : valeur exacte des tables de finales (un gain y vaut ±99)
+	if (NB_BITS(conf->occTout) <= nbPiecesFinales && sonderFinale(conf, mode, &score, NULL))
+		return (score == FINALE_NULLE ? 0 : ((score == FINALE_GAIN) == (mode == MAX) ? +99 : -99));
+
+	// à la frontière, les prises en cours sont menées à terme avant d'estimer (effet d'horizon)
+	if (niv == 0)
+		return quiescence(conf, mode, alpha, beta, numFctEst);
+
+	// la position a peut-être déjà été évaluée (par un autre ordre des coups ou une recherche
+	// précédente) ; sinon son meilleur coup connu est essayé en premier
+	cle = conf->cle ^ zobEst[estimEffective(numFctEst)];
+	if (sonderTT(cle, niv, alpha, beta, &score, &meilleur))
+		return score;
+
+	// conf précède les positions explorées à partir d'elle
+	historique[nbHistorique++] = conf->cle;
+
+	// Coup nul : si le joueur, même en passant son tour, dépasse encore sa borne à une profondeur
+	// réduite, un vrai coup la dépasserait aussi. Jamais en échec (passer serait illégal), sans
+	// pièce autre que les pions et le roi (risque de zugzwang), ni juste après un autre coup nul
+	coul = COULEUR(mode);
+	echec = enEchec(conf, coul);
+	if (niv >= 3 && !echec && (mode == MAX ? beta < 90 : alpha > -90) &&
+		(conf->occ[coul] & ~(conf->pieces[coul][PION] | conf->pieces[coul][ROI])) &&
+		nbHistorique >= 2 && historique[nbHistorique - 2] != (conf->cle ^ zobTrait) &&
+		(mode == MAX ? estimer(conf, numFctEst) >= beta : estimer(conf, numFctEst) <= alpha))
+	{
+		r = (niv >= 7 ? 3 : 2);
+		nbEssaisNuls++;
+		conf->cle ^= zobTrait;
+		if (mode == MAX)
+			score = minmax_ab(conf, MIN, niv - 1 - r, beta - 1, beta, largeur, numFctEst);
+		else
+			score = minmax_ab(conf, MAX, niv - 1 - r, alpha, alpha + 1, largeur, numFctEst);
+		conf->cle ^= zobTrait;
+		if (arretRecherche)
+		{
+			nbHistorique--;
+			return 0;
+		}
+		if (mode == MAX ? score >= beta : score <= alpha)
+		{
+			nbCoupesNulles++;
+			nbHistorique--;
+			return (mode == MAX ? beta : alpha);
+		}
+	}
+
+	// Les alternatives sont explorées en jouant chaque coup sur 'conf' puis en l'annulant,
+	// sans construire de configuration fille. Elles sont fournies par étapes par le sélecteur 's'
+	// (les prises d'abord), si bien qu'une coupe évite de générer les coups restants.
+	// PVS : la 1re alternative est explorée avec toute la fenêtre, les suivantes avec une fenêtre
+	// nulle qui vérifie seulement qu'elles ne font pas mieux (et qui est réexplorée sinon),
+	// les coups calmes tardifs l'étant d'abord à profondeur réduite (LMR)
+	nbFils = 0;
+	if (mode == MAX)
+	{
+
+		initSelecteur(&s, MAX, meilleur, tueurs[nbHistorique], largeur);
+		meilleur = COUP_NUL;
+
+		score = alpha;
+		while ((c = coupSuivant(conf, &s)) != COUP_NUL)
+		{
+			jouerCoup(conf, c, &u);
+			if (nbFils++ == 0)
+				score2 = minmax_ab(conf, MIN, niv - 1, score, beta, largeur, numFctEst);
+			else
+			{
+				r = reductionLMR(conf, &s, c, niv, nbFils, echec);
+				score2 = minmax_ab(conf, MIN, niv - 1 - r, score, score + 1, largeur, numFctEst);
+				if (r && score2 > score)
+				{
+					nbReexplorations++;
+					score2 = minmax_ab(conf, MIN, niv - 1, score, score + 1, largeur, numFctEst);
+				}
+				if (score2 > score && score + 1 < beta)
+					score2 = minmax_ab(conf, MIN, niv - 1, score, beta, largeur, numFctEst);
+			}
+			dejouerCoup(conf, c, &u);
+			if (arretRecherche)
+			{
+				nbHistorique--;
+				return 0;
+			}
+			if (score2 > score)
+			{
+				score = score2;
+				meilleur = c;
+			}
+			if (score >= beta)
+			{
+				// Coupe Beta
+				nbBeta++; // compteur de courpes beta
+				if (!EST_PRISE(c))
+					noterCoupe(BLANC, c, niv);
+				stockerTT(cle, niv, beta, BORNE_INF, c);
+				nbHistorique--;
+				return beta;
+			}
+		}
+	}
+	else
+	{ // mode == MIN
+
+		initSelecteur(&s, MIN, meilleur, tueurs[nbHistorique], largeur);
+		meilleur = COUP_NUL;
+
+		score = beta;
+		while ((c = coupSuivant(conf, &s)) != COUP_NUL)
+		{
+			jouerCoup(conf, c, &u);
+			if (nbFils++ == 0)
+				score2 = minmax_ab(conf, MAX, niv - 1, alpha, score, largeur, numFctEst);
+			else
+			{
+				r = reductionLMR(conf, &s, c, niv, nbFils, echec);
+				score2 = minmax_ab(conf, MAX, niv - 1 - r, score - 1, score, largeur, numFctEst);
+				if (r && score2 < score)
+				{
+					nbReexplorations++;
+					score2 = minmax_ab(conf, MAX, niv - 1, score - 1, score, largeur, numFctEst);
+				}
+				if (score2 < score && score - 1 > alpha)
+					score2 = minmax_ab(conf, MAX, niv - 1, alpha, score, largeur, numFctEst);
+			}
+			dejouerCoup(conf, c, &u);
+			if (arretRecherche)
+			{
+				nbHistorique--;
+				return 0;
+			}
+			if (score2 < score)
+			{
+				score = score2;
+				meilleur = c;
+			}
+			if (score <= alpha)
+			{
+				// Coupe Alpha
+				nbAlpha++; // compteur de courpes alpha
+				if (!EST_PRISE(c))
+					noterCoupe(NOIR, c, niv);
+				stockerTT(cle, niv, alpha, BORNE_SUP, c);
+				nbHistorique--;
+				return alpha;
+			}
+		}
+	}
+
+	nbHistorique--;
+
+	// aucun coup n'a amélioré la borne de départ : la valeur n'est connue que d'un côté
+	if (meilleur == COUP_NUL)
+		stockerTT(cle, niv, score, (mode == MAX ? BORNE_SUP : BORNE_INF), COUP_NUL);
+	else
+		stockerTT(cle, niv, score, BORNE_EXACTE, meilleur);
+
+	if (score == +INFINI)
+		score = +100;
+	if (score == -INFINI)
+		score = -100;
+
+	return score;
+
+} // fin de minmax_ab
+
+/* Les coups calmes de l'étape ETAPE_CALMES (donc ni le coup de hachage, ni un tueur) au-delà
+   du 4e sont réduits d'un niveau, et de 2 au-delà du 12e ; la profondeur restante doit
+   être d'au moins 3 pour qu'il en reste après la réduction */
+int reductionLMR(struct config *conf, struct selecteur *s, Coup c, int niv, int nbFils, int echec)
+{
+	if (niv < 3 || nbFils <= 4 || echec || s->etape != ETAPE_CALMES || EST_PROMO(c) ||
+		enEchec(conf, 1 - COULEUR(s->mode)))
+		return 0;
+	nbReductions++;
+	return (nbFils > 12 && niv >= 4 ? 2 : 1);
+
+} // fin de reductionLMR
+
+/* Recherche de quiescence (fail-hard, du point de vue de MAX comme minmax_ab).
+   Stand-pat : le joueur ayant le trait n'est pas obligé de prendre, l'estimation de la position
+   est donc déjà une borne pour lui. Les prises sont essayées de la plus forte victime à la plus
+   faible (puis du plus faible attaquant au plus fort), sauf celles qui, même en gagnant la pièce
+   prise (élagage delta), ne peuvent pas atteindre la borne du joueur */
+int quiescence(struct config *conf, int mode, int alpha, int beta, int numFctEst)
+{
+	int i, j, m, score, score2, estim, gain;
+	Coup c;
+	struct listeCoups L;
+	struct annul u;
+
+	if (arretRecherche || ((++nbNoeuds & 1023) == 0 && budgetEpuise()))
+		return 0;
+
+	if (feuille(conf, &score))
+		return score;
+
+	estim = estimer(conf, numFctEst);
+	if (mode == MAX)
+	{
+		if (estim >= beta)
+			return beta;
+		if (estim > alpha)
+			alpha = estim;
+	}
+	else
+	{
+		if (estim <= alpha)
+			return alpha;
+		if (estim < beta)
+			beta = estim;
+	}
+
+	// prises et transformations en reine, avec leur ordre MVV-LVA (comme dans coupSuivant)
+	generer_coups_vers(conf, mode, conf->occ[1 - COULEUR(mode)] | (~conf->occTout & RANGEES_PROMO), &L);
+	for (i = m = 0; i < L.n; i++)
+		if (EST_PRISE(L.c[i]) || (EST_PROMO(L.c[i]) && PIECE_PROMO(L.c[i]) == REINE))
+		{
+			L.c[m] = L.c[i];
+			L.val[m++] = 8 * conf->cases[VERS(L.c[i])] - conf->cases[DE(L.c[i])] +
+						 (EST_PROMO(L.c[i]) ? 8 * (REINE + 1) : 0);
+		}
+	L.n = m;
+
+	for (i = 0; i < L.n; i++)
+	{
+		// amener en position i la meilleure des prises restantes
+		m = i;
+		for (j = i + 1; j < L.n; j++)
+			if (L.val[j] > L.val[m])
+				m = j;
+		c = L.c[m];
+		L.c[m] = L.c[i];
+		L.val[m] = L.val[i];
+		L.c[i] = c;
+
+		gain = MARGE_DELTA + (conf->cases[VERS(c)] ? valeurPiece[conf->cases[VERS(c)] - 1] : 0) +
+			   (EST_PROMO(c) ? valeurPiece[PIECE_PROMO(c)] - valeurPiece[PION] : 0);
+		if (mode == MAX ? estim + gain <= alpha : estim - gain >= beta)
+			continue;
+
+		jouerCoup(conf, c, &u);
+		score2 = quiescence(conf, -mode, alpha, beta, numFctEst);
+		dejouerCoup(conf, c, &u);
+		if (arretRecherche)
+			return 0;
+		if (mode == MAX && score2 > alpha)
+		{
+			alpha = score2;
+			if (alpha >= beta)
+				return beta;
+		}
+		if (mode == MIN && score2 < beta)
+		{
+			beta = score2;
+			if (beta <= alpha)
+				return alpha;
+		}
+	}
+
+	return (mode == MAX ? alpha : beta);
+
+} // fin de quiescence
+
+/* Recherche par approfondissement itératif du meilleur coup de la racine conf.
+   Jusqu'à la profondeur h0, chaque alternative est évaluée exactement puis elles sont triées
+   (et limitées aux 'largeur' meilleures) ; au-delà, la racine est explorée par PVS dans une
+   fenêtre d'aspiration autour de la valeur précédente, élargie tant que la valeur en sort.
+   Une itération interrompue par l'épuisement du budget ne compte que si un coup y a battu
+   la borne de départ (le meilleur coup précédent, exploré en premier, y a donc été évalué)
+*/
+int chercherCoup(struct config *conf, int mode, struct listeCoups *L, int hauteur, int largeur,
+				 int numFctEst, int *score, int *prof)
+{
+	int i, d, n, j, jIter, cout, scoreIter, alpha, beta, fenetre;
+	struct annul u;
+	pthread_t th[64];
+
+	j = *prof = -1;
+	n = L->n;
+	interruptible = 0;
+
+	// les threads auxiliaires (Lazy SMP) partent de la même racine et du même historique
+	if (nbThreadsRecherche > 1 && !partageRacine)
+	{
+		copier(conf, &smpRacine);
+		smpL = *L;
+		smpMode = mode;
+		smpHauteur = hauteur;
+		smpLargeur = largeur;
+		smpEst = numFctEst;
+		smpHistorique = historique;
+		smpNbHistorique = nbHistorique;
+		for (i = 1; i < nbThreadsRecherche; i++)
+			pthread_create(&th[i], NULL, rechercheAuxiliaire, (void *)(long)i);
+	}
+
+	// les tueurs de la recherche précédente ne correspondent plus aux mêmes profondeurs,
+	// et son historique des coupes compte moins que celui de la nouvelle
+	memset(tueurs, 0, sizeof(tueurs));
+	attenuerHistoCoupes();
+	for (d = 0; d <= hauteur && n > 0; d++)
+	{
+		// une itération coûte plusieurs fois la précédente : inutile de la commencer
+		// si plus de la moitié du temps du coup est déjà consommée
+		if (d > 0 && tempsCoup > 0 && 2 * tempsEcoule() > tempsCoup)
+			break;
+
+		if (d <= h0 && partageRacine && nbThreadsRecherche > 1)
+		{
+			// les évaluations des alternatives sont indépendantes : elles sont réparties
+			// entre les threads (une itération interrompue est alors abandonnée)
+			jIter = -1;
+			partagerRacine(conf, mode, L, 0, n, d, -INFINI, +INFINI, 0, 1, largeur, numFctEst, &jIter);
+			scoreIter = (mode == MAX ? -INFINI : +INFINI);
+			jIter = -1;
+			for (i = 0; i < n && !arretRecherche; i++)
+				if (mode == MAX ? L->val[i] > scoreIter : L->val[i] < scoreIter)
+				{ // Choisir le meilleur coup
+					scoreIter = L->val[i];
+					jIter = i;
+				}
+		}
+		else if (d <= h0)
+		{
+			scoreIter = (mode == MAX ? -INFINI : +INFINI);
+			jIter = -1;
+			for (i = 0; i < n; i++)
+			{
+				jouerCoup(conf, L->c[i], &u);
+				cout = minmax_ab(conf, -mode, d, -INFINI, +INFINI, largeur, numFctEst);
+				dejouerCoup(conf, L->c[i], &u);
+				if (arretRecherche)
+					break;
+				L->val[i] = cout;
+				if (mode == MAX ? cout > scoreIter : cout < scoreIter)
+				{ // Choisir le meilleur coup
+					scoreIter = cout;
+					jIter = i;
+				}
+			}
+		}
+		else
+		{
+			fenetre = FENETRE_ASPIRATION;
+			alpha = *score - fenetre;
+			beta = *score + fenetre;
+			while (1)
+			{
+				scoreIter = explorerRacine(conf, mode, L, n, d, alpha, beta, largeur, numFctEst, &jIter);
+				if (arretRecherche)
+					break;
+				// la valeur sort de la fenêtre : elle est élargie du côté du dépassement (un coup
+				// qui a dépassé la borne du joueur est réexploré en premier)
+				fenetre *= 4;
+				if ((mode == MAX ? scoreIter <= alpha : scoreIter >= beta) && jIter == -1)
+				{
+					if (mode == MAX && alpha > -INFINI)
+						alpha = (fenetre > 100 ? -INFINI : *score - fenetre);
+					else if (mode == MIN && beta < +INFINI)
+						beta = (fenetre > 100 ? +INFINI : *score + fenetre);
+					else
+						break;
+				}
+				else if (mode == MAX ? scoreIter >= beta && beta < +INFINI
+									 : scoreIter <= alpha && alpha > -INFINI)
+				{
+					avancerCoup(L, jIter);
+					j = 0;
+					if (mode == MAX)
+						beta = (fenetre > 100 ? +INFINI : *score + fenetre);
+					else
+						alpha = (fenetre > 100 ? -INFINI : *score - fenetre);
+				}
+				else
+					break;
+			}
+		}
+
+		if (jIter != -1)
+		{
+			j = jIter;
+			*score = scoreIter;
+		}
+		if (arretRecherche)
+			break;
+		*prof = d;
+		interruptible = 1;
+		printf(".");
+		fflush(stdout);
+
+		if (d <= h0)
+		{
+			// tri des alternatives suivant leurs valeurs (le meilleur coup, premier
+			// de sa valeur, le reste), limitées aux 'largeur' meilleures après la dernière
+			// évaluation exacte (à h0, ou à hauteur si la recherche s'arrête avant)
+			trierCoups(L, mode);
+			if (j != -1)
+				j = 0;
+			if (d == (hauteur < h0 ? hauteur : h0) && largeur < n)
+				n = largeur;
+		}
+		else if (j > 0)
+		{
+			// le meilleur coup sera exploré en premier à l'itération suivante
+			avancerCoup(L, j);
+			j = 0;
+		}
+	}
+
+	// arrêt des threads auxiliaires
+	arretRecherche = 1;
+	for (i = 1; i < nbThreadsRecherche && !partageRacine; i++)
+		pthread_join(th[i], NULL);
+	__sync_fetch_and_add(&nbNoeudsTous, nbNoeuds & 1023);
+
+	arretRecherche = interruptible = 0;
+	return j;
+
+} // fin de chercherCoup
+
+/* Le thread principal participe à l'exploration partagée comme les autres (thread 0),
+   qui sont créés pour elle et attendus à sa fin */
+int partagerRacine(struct config *conf, int mode, struct listeCoups *L, int premier, int n, int niv,
+				   int alpha, int beta, int borne, int pleine, int largeur, int numFctEst, int *meilleur)
+{
+	int i;
+	pthread_t th[64];
+
+	copier(conf, &parRacine);
+	parL = L;
+	parMode = mode;
+	parNiv = niv;
+	parAlpha = alpha;
+	parBeta = beta;
+	parPleine = pleine;
+	parLargeur = largeur;
+	parEst = numFctEst;
+	parN = n;
+	parProchain = premier;
+	parBorne = borne;
+	parMeilleur = *meilleur;
+	smpHistorique = historique;
+	smpNbHistorique = nbHistorique;
+
+	for (i = 1; i < nbThreadsRecherche; i++)
+		pthread_create(&th[i], NULL, racineThread, (void *)(long)i);
+	racineThread(NULL);
+	for (i = 1; i < nbThreadsRecherche; i++)
+		pthread_join(th[i], NULL);
+
+	*meilleur = parMeilleur;
+	return parBorne;
+
+} // fin de partagerRacine
+
+/* Chaque thread prend le prochain coup non exploré jusqu'à épuisement des coups ou sortie de
+   la borne commune hors de la fenêtre. Un coup doit battre la borne commune au moment où il
+   est pris : il est d'abord exploré avec une fenêtre nulle, et réexploré s'il la bat */
+void *racineThread(void *arg)
+{
+	int i, b, cout, num = (int)(long)arg;
+	struct config conf;
+	struct annul u;
+
+	copier(&parRacine, &conf);
+	if (num != 0)
+	{
+		memcpy(historique, smpHistorique, smpNbHistorique * sizeof(bitboard));
+		nbHistorique = smpNbHistorique;
+		nbNoeuds = 0;
+	}
+
+	while (!arretRecherche && (parPleine || (parMode == MAX ? parBorne < parBeta : parBorne > parAlpha)) &&
+		   (i = __sync_fetch_and_add(&parProchain, 1)) < parN)
+	{
+		b = parBorne;
+		jouerCoup(&conf, parL->c[i], &u);
+		if (parPleine)
+			cout = minmax_ab(&conf, -parMode, parNiv, -INFINI, +INFINI, parLargeur, parEst);
+		else if (parMode == MAX)
+		{
+			cout = minmax_ab(&conf, MIN, parNiv, b, b + 1, parLargeur, parEst);
+			if (cout > b && b + 1 < parBeta)
+				cout = minmax_ab(&conf, MIN, parNiv, b, parBeta, parLargeur, parEst);
+		}
+		else
+		{
+			cout = minmax_ab(&conf, MAX, parNiv, b - 1, b, parLargeur, parEst);
+			if (cout < b && b - 1 > parAlpha)
+				cout = minmax_ab(&conf, MAX, parNiv, parAlpha, b, parLargeur, parEst);
+		}
+		dejouerCoup(&conf, parL->c[i], &u);
+		if (arretRecherche)
+			break;
+
+		if (parPleine)
+			parL->val[i] = cout;
+		else
+		{
+			pthread_mutex_lock(&parVerrou);
+			if (parMode == MAX ? cout > parBorne : cout < parBorne)
+			{
+				parBorne = cout;
+				parMeilleur = i;
+			}
+			pthread_mutex_unlock(&parVerrou);
+		}
+	}
+
+	if (num != 0)
+	{
+		__sync_fetch_and_add(&nbNoeudsTous, nbNoeuds & 1023);
+		reporterStatistiques();
+	}
+	return NULL;
+
+} // fin de racineThread
+
+/* Les threads auxiliaires ont leurs propres tueurs et historique des coupes, si bien qu'ils
+   n'explorent pas l'arbre dans le même ordre que le thread principal ; de plus, les threads
+   impairs ont une itération d'avance sur les pairs. Leurs résultats ne servent que par
+   la table de transposition, où le thread principal les trouve */
+void *rechercheAuxiliaire(void *arg)
+{
+	int d, j, num = (int)(long)arg;
+	struct config conf;
+	struct listeCoups L;
+
+	copier(&smpRacine, &conf);
+	L = smpL;
+	memcpy(historique, smpHistorique, smpNbHistorique * sizeof(bitboard));
+	nbHistorique = smpNbHistorique;
+	nbNoeuds = 0;
+
+	for (d = 1 + num % 2; d <= smpHauteur && !arretRecherche; d++)
+	{
+		explorerRacine(&conf, smpMode, &L, L.n, d, -INFINI, +INFINI, smpLargeur, smpEst, &j);
+		if (j > 0)
+			avancerCoup(&L, j);
+	}
+
+	__sync_fetch_and_add(&nbNoeudsTous, nbNoeuds & 1023);
+	reporterStatistiques();
+	return NULL;
+
+} // fin de rechercheAuxiliaire
+
+/* PVS à la racine : le 1er coup (le meilleur de l'itération précédente) est exploré avec toute
+   la fenêtre, les suivants avec une fenêtre nulle et réexplorés seulement s'ils font mieux */
+int explorerRacine(struct config *conf, int mode, struct listeCoups *L, int n, int niv,
+				   int alpha, int beta, int largeur, int numFctEst, int *meilleur)
+{
+	int i, score, cout;
+	struct annul u;
+
+	*meilleur = -1;
+	score = (mode == MAX ? alpha : beta);
+	for (i = 0; i < n; i++)
+	{
+		// Young Brothers Wait : une fois le 1er coup exploré, les suivants le sont en parallèle
+		if (i == 1 && partageRacine && nbThreadsRecherche > 1)
+			return partagerRacine(conf, mode, L, 1, n, niv, alpha, beta, score, 0, largeur, numFctEst, meilleur);
+
+		jouerCoup(conf, L->c[i], &u);
+		if (mode == MAX)
+		{
+			if (i == 0)
+				cout = minmax_ab(conf, MIN, niv, score, beta, largeur, numFctEst);
+			else
+			{
+				cout = minmax_ab(conf, MIN, niv, score, score + 1, largeur, numFctEst);
+				if (cout > score && score + 1 < beta)
+					cout = minmax_ab(conf, MIN, niv, score, beta, largeur, numFctEst);
+			}
+		}
+		else
+		{
+			if (i == 0)
+				cout = minmax_ab(conf, MAX, niv, alpha, score, largeur, numFctEst);
+			else
+			{
+				cout = minmax_ab(conf, MAX, niv, score - 1, score, largeur, numFctEst);
+				if (cout < score && score - 1 > alpha)
+					cout = minmax_ab(conf, MAX, niv, alpha, score, largeur, numFctEst);
+			}
+		}
+		dejouerCoup(conf, L->c[i], &u);
+		if (arretRecherche)
+			break;
+		if (mode == MAX ? cout > score : cout < score)
+		{ // Choisir le meilleur coup
+			score = cout;
+			*meilleur = i;
+		}
+		if (mode == MAX ? score >= beta : score <= alpha)
+			break; // la valeur sort de la fenêtre
+	}
+	return score;
+
+} // fin de explorerRacine
+
+/* Place le coup d'indice j en tête de L, les précédents étant décalés d'un rang */
+void avancerCoup(struct listeCoups *L, int j)
+{
+	int i, v;
+	Coup c;
+
+	c = L->c[j];
+	v = L->val[j];
+	for (i = j; i > 0; i--)
+	{
+		L->c[i] = L->c[i - 1];
+		L->val[i] = L->val[i - 1];
+	}
+	L->c[0] = c;
+	L->val[0] = v;
+
+} // fin de avancerCoup
+
+/* Commence le décompte du temps et des noeuds de la recherche d'un coup */
+void debutRecherche()
+{
+	clock_gettime(CLOCK_MONOTONIC, &debutCoup);
+	nbNoeuds = nbNoeudsTous = 0;
+	nbAlpha = nbBeta = 0;
+	nbEssaisNuls = nbCoupesNulles = nbReductions = nbReexplorations = 0;
+	arretRecherche = 0;
+
+} // fin de debutRecherche
+
+/* Temps écoulé (en ms) depuis debutRecherche */
+long tempsEcoule()
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (t.tv_sec - debutCoup.tv_sec) * 1000 + (t.tv_nsec - debutCoup.tv_nsec) / 1000000;
+
+} // fin de tempsEcoule
+
+/* Contrôle du budget de la recherche, appelé tous les 1024 noeuds d'un thread
+   (la 1re itération du thread principal n'est jamais interrompue) */
+int budgetEpuise()
+{
+	long long n = __sync_add_and_fetch(&nbNoeudsTous, 1024);
+
+	if (interruptible && ((tempsCoup > 0 && tempsEcoule() >= tempsCoup) ||
+						  (noeudsMax > 0 && n >= noeudsMax)))
+		arretRecherche = 1;
+	return arretRecherche;
+
+} // fin de budgetEpuise
+
+/* Le temps restant est réparti sur les coups qui restent à jouer (estimés à 40 moins la
+   moitié des coups déjà joués par chaque joueur, et au moins 10), plus les 3/4 de
+   l'incrément ; un coup ne prend jamais plus du tiers du temps restant */
+long allouerTemps(long restant, long increment, long tempsMax)
+{
+	long t, nbCoups = 40 - num_coup / 4;
+
+	if (nbCoups < 10)
+		nbCoups = 10;
+	t = restant / nbCoups + 3 * increment / 4;
+	if (t > restant / 3)
+		t = restant / 3;
+	if (tempsMax > 0 && t > tempsMax)
+		t = tempsMax;
+	if (t < 1)
+		t = 1;
+	return t;
+
+} // fin de allouerTemps
+
+// ********************************
+// Partie:  Tables de finales
+// ********************************
+
+/* Charge la table de finale du fichier nomf */
+int chargerFinale(char *nomf)
+{
+	int fd, ok = 0;
+	struct stat st;
+	struct enteteFinale *e;
+
+	if (nbFinales == MAX_FINALES)
+		return 0;
+	fd = open(nomf, O_RDONLY);
+	if (fd < 0)
+		return 0;
+	if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(struct enteteFinale))
+	{
+		e = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (e != MAP_FAILED && strcmp(e->signature, "FINALE") == 0 && e->version == VERSION_FINALE &&
+			st.st_size == (off_t)(sizeof(struct enteteFinale) + (2 * e->nbPositions + 3) / 4 +
+								  (e->distances ? 2 * e->nbPositions : 0)))
+		{
+			finales[nbFinales++] = e;
+			if ((int)e->nbPieces > nbPiecesFinales)
+				nbPiecesFinales = e->nbPieces;
+			ok = 1;
+		}
+		else if (e != MAP_FAILED)
+			munmap(e, st.st_size);
+	}
+	close(fd);
+	return ok;
+
+} // fin de chargerFinale
+
+/* Charge les fichiers '.fin' de rep */
+int ouvrirFinales(char *rep)
+{
+	DIR *d;
+	struct dirent *f;
+	char nomf[1024];
+	int l;
+
+	d = opendir(rep);
+	if (d == NULL)
+		return 0;
+	while ((f = readdir(d)) != NULL)
+	{
+		l = strlen(f->d_name);
+		if (l < 5 || strcmp(f->d_name + l - 4, ".fin") != 0)
+			continue;
+		snprintf(nomf, sizeof(nomf), "%s/%s", rep, f->d_name);
+		chargerFinale(nomf);
+	}
+	closedir(d);
+	return nbFinales;
+
+} // fin de ouvrirFinales
+
+/* Indice de conf dans une table de finale (les couleurs étant échangées et l'échiquier
+   retourné si 'miroir' vaut 1) */
+bitboard indiceFinale(struct config *conf, int miroir)
+{
+	int coul, type, k = 0;
+	bitboard b, indice = 0;
+
+	for (coul = BLANC; coul <= NOIR; coul++)
+		for (type = PION; type <= ROI; type++)
+		{
+			// les rangées du miroir sont inversées en renversant l'ordre des octets, si bien que
+			// les pièces identiques restent parcourues dans l'ordre croissant de leurs cases
+			b = conf->pieces[coul ^ miroir][type];
+			if (miroir)
+				b = __builtin_bswap64(b);
+			for (; b; b &= b - 1)
+			{
+				indice |= (bitboard)PREMIER_BIT(b) << (6 * k);
+				k++;
+			}
+		}
+	return indice;
+
+} // fin de indiceFinale
+
+/* Teste si les pièces de conf (aux couleurs échangées si miroir vaut 1) sont celles de la table e */
+int memeMateriel(struct config *conf, struct enteteFinale *e, int miroir)
+{
+	int coul, type;
+
+	for (coul = BLANC; coul <= NOIR; coul++)
+		for (type = PION; type <= ROI; type++)
+			if (NB_BITS(conf->pieces[coul ^ miroir][type]) != e->nb[coul][type])
+				return 0;
+	return 1;
+} // fin de memeMateriel
+
+/* Valeur de conf (mode ayant le trait) dans les tables de finales */
+int sonderFinale(struct config *conf, int mode, int *val, int *dist)
+{
+	int i, miroir;
+	bitboard p;
+	unsigned char *t;
+	struct enteteFinale *e;
+
+	// les 2 rois seuls : nulle
+	if (NB_BITS(conf->occTout) == 2)
+	{
+		*val = FINALE_NULLE;
+		if (dist)
+			*dist = 0;
+		return 1;
+	}
+
+	// les tables supposent qu'aucun roque n'est plus possible
+	if ((conf->roqueB != 'n' && conf->roqueB != 'e') || (conf->roqueN != 'n' && conf->roqueN != 'e'))
+		return 0;
+
+	// chercher la table de la répartition des pièces (ou de la répartition aux couleurs échangées)
+	for (i = 0; i < nbFinales; i++)
+		for (miroir = 0; miroir <= 1; miroir++)
+			if (memeMateriel(conf, finales[i], miroir))
+			{
+				// les Blancs de la table sont les Noirs de conf si miroir vaut 1
+				e = finales[i];
+				p = indiceFinale(conf, miroir) + ((mode == MAX) != miroir ? 0 : e->nbPositions);
+				t = (unsigned char *)(e + 1);
+				*val = (t[p >> 2] >> (2 * (p & 3))) & 3;
+				if (dist)
+					*dist = (e->distances ? t[(2 * e->nbPositions + 3) / 4 + p] : -1);
+				return *val != FINALE_INCONNUE;
+			}
+	return 0;
+
+} // fin de sonderFinale
+
+/* Valeur de conf dans les tables quel que soit le joueur ayant le trait */
+int valeurFinale(struct config *conf, int *score)
+{
+	int vB, vN;
+
+	if (NB_BITS(conf->occTout) > nbPiecesFinales || !sonderFinale(conf, MAX, &vB, NULL) ||
+		!sonderFinale(conf, MIN, &vN, NULL))
+		return 0;
+	if (vB == FINALE_NULLE && vN == FINALE_NULLE)
+		*score = 0;
+	else if (vB == FINALE_GAIN && vN == FINALE_PERTE)
+		*score = +99;
+	else if (vB == FINALE_PERTE && vN == FINALE_GAIN)
+		*score = -99;
+	else
+		return 0; // la valeur dépend du trait
+	return 1;
+
+} // fin de valeurFinale
+
+/* Coup des tables de finales pour conf : chaque coup est jugé par la valeur de la position
+   obtenue (pour l'adversaire) ; une conversion vers une table gagnante compte comme une
+   distance nulle pour le gagnant */
+int coupFinale(struct config *conf, int mode, struct listeCoups *L, Coup *c, int *score)
+{
+	int i, v, d, val, dist, meilleur = -1, dMeilleur = 0;
+	struct annul u;
+
+	if (NB_BITS(conf->occTout) > nbPiecesFinales || !sonderFinale(conf, mode, &val, &dist))
+		return 0;
+	if (dist < 0 && val != FINALE_NULLE)
+		return 0; // sans les distances, le chemin du gain est laissé à la recherche
 
-					(*n)++;
-					a = a + D[i][0];
-					b = b + D[i][1];
-				}
-			} // while
-		}	 // for
-		break;
+	for (i = 0; i < L->n; i++)
+	{
+		jouerCoup(conf, L->c[i], &u);
+		if (sonderFinale(conf, -mode, &v, &d))
+		{
+			if (EST_PRISE(L->c[i]) || EST_PROMO(L->c[i]))
+				d = 0;
+			// gain : le plus court chemin ; perte : le plus long ; nulle : tout coup la gardant
+			if ((val == FINALE_GAIN && v == FINALE_PERTE && (meilleur == -1 || d < dMeilleur)) ||
+				(val == FINALE_PERTE && v == FINALE_GAIN && (meilleur == -1 || d > dMeilleur)) ||
+				(val == FINALE_NULLE && v == FINALE_NULLE && meilleur == -1))
+			{
+				meilleur = i;
+				dMeilleur = d;
+			}
+		}
+		dejouerCoup(conf, L->c[i], &u);
+	}
+	if (meilleur == -1)
+		return 0; // une table manque pour juger les coups : laisser faire la recherche
 
-	// mvmt REINE ...
-	case 'n':
-		for (i = 0; i < 8; i += 1)
-		{
-			// traitement des 8 directions paires et impaires
-			stop = 0;
-			a = x + D[i][0];
-			b = y + D[i][1];
-			while (!stop && a >= 0 && a <= 7 && b >= 0 && b <= 7)
+	*c = L->c[meilleur];
+	*score = (val == FINALE_NULLE ? 0 : ((val == FINALE_GAIN) == (mode == MAX) ? +99 : -99));
+	return 1;
+
+} // fin de coupFinale
+
+// *****************************************
+// Partie:  Génération des tables de finales
+// *****************************************
+
+/* Pose sur conf la position d'indice p de la table e (les Blancs ayant le trait si p < nbPositions).
+   Retourne le joueur ayant le trait, ou 0 si l'indice ne correspond à aucune position : 2 pièces
+   sur une même case, pièces identiques hors de l'ordre croissant des cases (indice d'une autre
+   position), pion sur sa 1re rangée, ou joueur n'ayant pas le trait en échec */
+int poserFinale(struct config *conf, struct enteteFinale *e, bitboard p)
+{
+	int coul, type, i, c, prec, mode = (p < e->nbPositions ? MAX : MIN);
+
+	memset(conf, 0, sizeof(struct config));
+	conf->roqueB = 'n';
+	conf->roqueN = 'n';
+	p %= e->nbPositions;
+	for (coul = BLANC; coul <= NOIR; coul++)
+		for (type = PION; type <= ROI; type++)
+			for (i = 0, prec = -1; i < e->nb[coul][type]; i++, p >>= 6)
 			{
-				if (conf->mat[a][b] > 0)
-					stop = 1;
-				else
-				{
-					copier(conf, &T[*n]);
-					T[*n].mat[x][y] = 0;
-					if (T[*n].mat[a][b] < 0)
-						stop = 1;
-					T[*n].mat[a][b] = 'n';
-					// cas où le roi adverse est pris...
-					if (T[*n].xrN == a && T[*n].yrN == b)
-					{
-						T[*n].xrN = -1;
-						T[*n].yrN = -1;
-					}
-					(*n)++;
-					a = a + D[i][0];
-					b = b + D[i][1];
-				}
-			} // while
-		}	 // for
-		break;
+				c = p & 63;
+				if ((conf->occTout & BIT(c)) || c < prec || (type == PION && LIGNE(c) == 7 * coul))
+					return 0;
+				poserPiece(conf, coul, type, c);
+				prec = c;
+			}
+	conf->xrB = LIGNE(PREMIER_BIT(conf->pieces[BLANC][ROI]));
+	conf->yrB = COLONNE(PREMIER_BIT(conf->pieces[BLANC][ROI]));
+	conf->xrN = LIGNE(PREMIER_BIT(conf->pieces[NOIR][ROI]));
+	conf->yrN = COLONNE(PREMIER_BIT(conf->pieces[NOIR][ROI]));
 
-	// mvmt ROI ...
-	case 'r':
-		// vérifier possibilité de faire un roque ...
-		if (conf->roqueB != 'n' && conf->roqueB != 'e')
-		{
-			if (conf->roqueB != 'g' && conf->mat[0][1] == 0 &&
-				conf->mat[0][2] == 0 && conf->mat[0][3] == 0)
-				if (!caseMenaceePar(MIN, 0, 1, conf) && !caseMenaceePar(MIN, 0, 2, conf) &&
-					!caseMenaceePar(MIN, 0, 3, conf) && !caseMenaceePar(MIN, 0, 4, conf))
-				{
-					// Faire un grand roque ...
-					copier(conf, &T[*n]);
-					T[*n].mat[0][4] = 0;
-					T[*n].mat[0][0] = 0;
-					T[*n].mat[0][2] = 'r';
-					T[*n].xrB = 0;
-					T[*n].yrB = 2;
-					T[*n].mat[0][3] = 't';
-					// aucun roque ne sera plus possible à partir de cette config
-					T[*n].roqueB = 'e';
-					(*n)++;
-				}
-			if (conf->roqueB != 'p' && conf->mat[0][5] == 0 && conf->mat[0][6] == 0)
-				if (!caseMenaceePar(MIN, 0, 4, conf) && !caseMenaceePar(MIN, 0, 5, conf) &&
-					!caseMenaceePar(MIN, 0, 6, conf))
+	coul = (mode == MAX ? NOIR : BLANC);
+	if (attaquants(conf, PREMIER_BIT(conf->pieces[coul][ROI]), 1 - coul, conf->occTout))
+		return 0;
+	return mode;
+
+} // fin de poserFinale
+
+/* 1re phase (un thread) : valeur des positions décidées par leurs seuls coups sortant de la table
+   (prises et transformations, jugées avec les tables déjà calculées) ou sans coup possible,
+   et nombre de coups restant dans la table pour les autres */
+void *genInitThread(void *arg)
+{
+	bitboard p, deb, fin, total = 2 * genTable->nbPositions;
+	int i, mode, v, gain, issue, fils;
+	struct config conf;
+	struct listeCoups L;
+	struct annul u;
+
+	(void)arg;
+	while ((deb = __sync_fetch_and_add(&genProchain, GEN_BLOC)) < total)
+	{
+		fin = (deb + GEN_BLOC < total ? deb + GEN_BLOC : total);
+		for (p = deb; p < fin; p++)
+		{
+			mode = poserFinale(&conf, genTable, p);
+			if (mode == 0)
+			{
+				genVal[p] = GEN_IMPOSSIBLE;
+				continue;
+			}
+			generer_coups(&conf, mode, &L);
+			gain = issue = fils = 0;
+			for (i = 0; i < L.n && !gain; i++)
+				if (EST_PRISE(L.c[i]) || EST_PROMO(L.c[i]))
 				{
-					// Faire un petit roque ...
-					copier(conf, &T[*n]);
-					T[*n].mat[0][4] = 0;
-					T[*n].mat[0][7] = 0;
-					T[*n].mat[0][6] = 'r';
-					T[*n].xrB = 0;
-					T[*n].yrB = 6;
-					T[*n].mat[0][5] = 't';
-					// aucun roque ne sera plus possible à partir de cette config
-					T[*n].roqueB = 'e';
-					(*n)++;
+					jouerCoup(&conf, L.c[i], &u);
+					if (!sonderFinale(&conf, -mode, &v, NULL))
+						issue = 1; // table manquante : on suppose que ce coup ne perd pas
+					else if (v == FINALE_PERTE)
+						gain = 1;
+					else if (v == FINALE_NULLE)
+						issue = 1;
+					dejouerCoup(&conf, L.c[i], &u);
 				}
+				else
+					fils++;
+
+			if (gain)
+			{
+				genVal[p] = FINALE_GAIN;
+				genDist[p] = 1;
+			}
+			else if (fils == 0 && !issue)
+			{
+				// aucun coup (perte immédiate) ou seulement des sorties perdantes
+				genVal[p] = FINALE_PERTE;
+				genDist[p] = (L.n == 0 ? 0 : 1);
+			}
+			else
+				genFils[p] = fils | (issue ? GEN_ISSUE : 0);
 		}
+	}
+	return NULL;
+
+} // fin de genInitThread
+
+/* Phase suivante (un thread) : les positions décidées à la distance genNiveau décident
+   leurs prédécesseurs dans la table (positions d'où le dernier coup a pu être joué) */
+void *genNiveauThread(void *arg)
+{
+	bitboard p, q, deb, fin, sources, total = 2 * genTable->nbPositions;
+	int mode, coul, type, c, f, av, roi;
+	bitboard b;
+	struct config conf;
 
-		// vérifier les autres mouvements du roi ...
-		for (i = 0; i < 8; i += 1)
+	(void)arg;
+	while ((deb = __sync_fetch_and_add(&genProchain, GEN_BLOC)) < total)
+	{
+		fin = (deb + GEN_BLOC < total ? deb + GEN_BLOC : total);
+		for (p = deb; p < fin; p++)
 		{
-			// traitement des 8 directions paires et impaires
-			a = x + D[i][0];
-			b = y + D[i][1];
-			if (a >= 0 && a <= 7 && b >= 0 && b <= 7)
-				if (conf->mat[a][b] <= 0)
+			if (genDist[p] != genNiveau || (genVal[p] != FINALE_GAIN && genVal[p] != FINALE_PERTE))
+				continue;
+			mode = poserFinale(&conf, genTable, p);
+			coul = (mode == MAX ? NOIR : BLANC); // joueur ayant joué le dernier coup
+			roi = PREMIER_BIT(conf.pieces[1 - coul][ROI]);
+			for (type = PION; type <= ROI; type++)
+				for (b = conf.pieces[coul][type]; b; b &= b - 1)
 				{
-					copier(conf, &T[*n]);
-					T[*n].mat[x][y] = 0;
-					T[*n].mat[a][b] = 'r';
-					T[*n].xrB = a;
-					T[*n].yrB = b;
-					// cas où le roi adverse est pris...
-					if (T[*n].xrN == a && T[*n].yrN == b)
+					c = PREMIER_BIT(b);
+					// cases d'où la pièce a pu venir (vides dans p)
+					if (type == PION)
+					{
+						av = (coul == BLANC ? 8 : -8);
+						sources = 0;
+						if (c - av >= 0 && c - av < 64 && LIGNE(c - av) != 7 * coul && !(conf.occTout & BIT(c - av)))
+						{
+							sources = BIT(c - av);
+							if (LIGNE(c) == (coul == BLANC ? 3 : 4) && !(conf.occTout & BIT(c - 2 * av)))
+								sources |= BIT(c - 2 * av);
+						}
+					}
+					else if (type == CAVALIER)
+						sources = attCavalier[c];
+					else if (type == FOU)
+						sources = attFou(c, conf.occTout);
+					else if (type == TOUR)
+						sources = attTour(c, conf.occTout);
+					else if (type == REINE)
+						sources = attFou(c, conf.occTout) | attTour(c, conf.occTout);
+					else
+						sources = attRoi[c];
+
+					for (sources &= ~conf.occTout; sources; sources &= sources - 1)
 					{
-						T[*n].xrN = -1;
-						T[*n].yrN = -1;
+						f = PREMIER_BIT(sources);
+						enleverPiece(&conf, coul, type, c);
+						poserPiece(&conf, coul, type, f);
+						// le prédécesseur doit être une position possible (adversaire pas en échec)
+						if (!attaquants(&conf, roi, coul, conf.occTout))
+						{
+							q = indiceFinale(&conf, 0) + (mode == MAX ? genTable->nbPositions : 0);
+							if (genVal[p] == FINALE_PERTE)
+							{
+								// un coup menant à une position perdue pour l'adversaire : gain
+								if (__sync_bool_compare_and_swap(&genVal[q], 0, FINALE_GAIN))
+								{
+									genDist[q] = genNiveau + 1;
+									genNouveaux = 1;
+								}
+							}
+							else if (__sync_sub_and_fetch(&genFils[q], 1) == 0 &&
+									 __sync_bool_compare_and_swap(&genVal[q], 0, FINALE_PERTE))
+							{
+								// son dernier coup dans la table mène au gain adverse : perte
+								genDist[q] = genNiveau + 1;
+								genNouveaux = 1;
+							}
+						}
+						enleverPiece(&conf, coul, type, f);
+						poserPiece(&conf, coul, type, c);
 					}
-					// aucun roque ne sera plus possible à partir de cette config
-					T[*n].roqueB = 'n';
-					(*n)++;
 				}
-		} // for
-		break;
+		}
 	}
+	return NULL;
 
-} // fin de deplacementsB
+} // fin de genNiveauThread
 
-/* Génère les successeurs de la configuration conf dans le tableau T, 
-   retourne aussi dans n le nombre de configurations filles générées */
-void generer_succ(struct config *conf, int mode, struct config T[], int *n)
+/* Lance nbThreads threads exécutant fct sur toutes les positions de la table en cours */
+void genLancer(void *(*fct)(void *), int nbThreads)
 {
-	int i, j, k, stop;
+	int i;
+	pthread_t th[64];
 
-	*n = 0;
+	genProchain = 0;
+	for (i = 1; i < nbThreads; i++)
+		pthread_create(&th[i], NULL, fct, NULL);
+	fct(NULL);
+	for (i = 1; i < nbThreads; i++)
+		pthread_join(th[i], NULL);
 
-	if (mode == MAX)
-	{ // mode == MAX
-		for (i = 0; i < 8; i++)
-			for (j = 0; j < 8; j++)
-				if (conf->mat[i][j] > 0)
-					deplacementsB(conf, i, j, T, n);
-
-		// vérifier si le roi est en echec, auquel cas on ne garde que les succ évitants l'échec
-		// ou alors si une conf est déjà visitée dans Partie, auquel cas on l'enlève aussi ...
-		for (k = 0; k < *n; k++)
-		{
-			i = T[k].xrB;
-			j = T[k].yrB; // pos du roi B dans T[k]
-			// vérifier si roi menacé dans la config T[k] ou alors T[k] est dejà visitée ...
-			if (caseMenaceePar(MIN, i, j, &T[k]) || dejaVisitee(&T[k]))
-			{
-				T[k] = T[(*n) - 1]; // alors supprimer T[k] de la liste des succ...
-				(*n)--;
-				k--;
-			}
-		} // for k
+} // fin de genLancer
+
+/* Calcule par analyse rétrograde la table des pièces nb (par nbThreads threads)
+   et l'écrit dans le fichier nomf, avec les distances si distances vaut 1 */
+int genererFinale(char *nomf, char nb[2][6], int distances, int nbThreads)
+{
+	struct enteteFinale e;
+	bitboard p, total, taille;
+	unsigned char *t;
+	int coul, type;
+	FILE *fl;
+
+	memset(&e, 0, sizeof(e));
+	strcpy(e.signature, "FINALE");
+	e.version = VERSION_FINALE;
+	e.distances = distances;
+	for (coul = BLANC; coul <= NOIR; coul++)
+		for (type = PION; type <= ROI; type++)
+		{
+			e.nb[coul][type] = nb[coul][type];
+			e.nbPieces += nb[coul][type];
+		}
+	e.nbPositions = 1ULL << (6 * e.nbPieces);
+	total = 2 * e.nbPositions;
+
+	genTable = &e;
+	genVal = calloc(total, 1);
+	genFils = calloc(total, 1);
+	genDist = malloc(total * sizeof(unsigned short));
+	if (genVal == NULL || genFils == NULL || genDist == NULL)
+	{
+		free(genVal);
+		free(genFils);
+		free(genDist);
+		return 0;
 	}
+	memset(genDist, 0xFF, total * sizeof(unsigned short));
 
-	else
-	{ // mode == MIN
-		for (i = 0; i < 8; i++)
-			for (j = 0; j < 8; j++)
-				if (conf->mat[i][j] < 0)
-					deplacementsN(conf, i, j, T, n);
-
-		// vérifier si le roi est en echec, auquel cas on ne garde que les succ évitants l'échec
-		// ou alors si une conf est déjà visitée dans Partie, auquel cas on l'enlève aussi ...
-		for (k = 0; k < *n; k++)
-		{
-			i = T[k].xrN;
-			j = T[k].yrN;
-			// vérifier si roi menacé dans la config T[k] ou alors T[k] est dejà visitée ...
-			if (caseMenaceePar(MAX, i, j, &T[k]) || dejaVisitee(&T[k]))
-			{
-				T[k] = T[(*n) - 1]; // alors supprimer T[k] de la liste des succ...
-				(*n)--;
-				k--;
-			}
-		} // for k
-	}	 // if (mode == MAX) ... else ...
+	genLancer(genInitThread, nbThreads);
+	for (genNiveau = 0;; genNiveau++)
+	{
+		genNouveaux = 0;
+		genLancer(genNiveauThread, nbThreads);
+		if (!genNouveaux && genNiveau >= 1)
+			break;
+	}
 
-} // fin de generer_succ
+	// écriture : en-tête, valeurs sur 2 bits (les positions non décidées sont nulles) et distances
+	taille = (total + 3) / 4 + (distances ? total : 0);
+	t = calloc(taille, 1);
+	for (p = 0; p < total; p++)
+	{
+		if (genVal[p] == 0)
+			genVal[p] = FINALE_NULLE;
+		else if (genVal[p] == GEN_IMPOSSIBLE)
+			genVal[p] = FINALE_INCONNUE;
+		t[p >> 2] |= genVal[p] << (2 * (p & 3));
+		if (distances && (genVal[p] == FINALE_GAIN || genVal[p] == FINALE_PERTE))
+			t[(total + 3) / 4 + p] = (genDist[p] > 255 ? 255 : genDist[p]);
+	}
+	fl = fopen(nomf, "wb");
+	if (fl != NULL)
+	{
+		fwrite(&e, sizeof(e), 1, fl);
+		fwrite(t, taille, 1, fl);
+		fclose(fl);
+	}
+	free(t);
+	free(genVal);
+	free(genFils);
+	free(genDist);
+	return fl != NULL;
 
-// ******************************
-// Partie:  MinMax avec AlphaBeta
-// ******************************
+} // fin de genererFinale
+
+/* Génère dans rep les tables de 3 (ou 4) pièces qui n'y sont pas encore, dans un ordre où
+   les tables atteintes par une prise ou une transformation sont toujours calculées avant */
+int finalesMain(int argc, char *argv[])
+{
+	char cotes[21][3], nomf[1024], nb[2][6], *lettres = "QRBNP", *x;
+	int types[5] = {REINE, TOUR, FOU, CAVALIER, PION};
+	int i, j, m, pions, nbCotes = 0, maxPieces = 3, nbThreads = 1, distances = 1, li, lj;
+	struct stat st;
+	struct timespec t0, t1;
+
+	if (argc < 3)
+	{
+		printf("usage : %s finales <répertoire> [-pieces <3|4>] [-threads <n>] [-wdl]\n", argv[0]);
+		return 1;
+	}
+	for (i = 3; i < argc; i++)
+		if (strcmp(argv[i], "-pieces") == 0 && i + 1 < argc)
+			maxPieces = (atoi(argv[++i]) >= 4 ? 4 : 3);
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+		{
+			nbThreads = atoi(argv[++i]);
+			if (nbThreads < 1)
+				nbThreads = 1;
+			if (nbThreads > 64)
+				nbThreads = 64;
+		}
+		else if (strcmp(argv[i], "-wdl") == 0)
+			distances = 0;
+
+	initBitboards();
+	mkdir(argv[2], 0755);
+	ouvrirFinales(argv[2]);
+
+	// pièces (hors roi) que peut avoir un camp : aucune, une ou deux
+	strcpy(cotes[nbCotes++], "");
+	for (i = 0; i < 5; i++)
+	{
+		cotes[nbCotes][0] = lettres[i];
+		cotes[nbCotes++][1] = '\0';
+	}
+	for (i = 0; i < 5; i++)
+		for (j = i; j < 5; j++)
+		{
+			cotes[nbCotes][0] = lettres[i];
+			cotes[nbCotes][1] = lettres[j];
+			cotes[nbCotes++][2] = '\0';
+		}
 
-/* Fonctions de comparaison utilisées avec qsort     */
-// 'a' et 'b' sont des configurations
+	// par nombre de pièces puis de pions croissants ; le camp le plus fort est celui des Blancs
+	for (m = 1; m <= maxPieces - 2; m++)
+		for (pions = 0; pions <= m; pions++)
+			for (i = 0; i < nbCotes; i++)
+				for (j = 0; j < nbCotes; j++)
+				{
+					li = strlen(cotes[i]);
+					lj = strlen(cotes[j]);
+					if (li + lj != m || li < lj || (li == lj && i > j))
+						continue;
+					memset(nb, 0, sizeof(nb));
+					nb[BLANC][ROI] = nb[NOIR][ROI] = 1;
+					for (x = cotes[i]; *x; x++)
+						nb[BLANC][types[strchr(lettres, *x) - lettres]]++;
+					for (x = cotes[j]; *x; x++)
+						nb[NOIR][types[strchr(lettres, *x) - lettres]]++;
+					if (nb[BLANC][PION] + nb[NOIR][PION] != pions)
+						continue;
+
+					snprintf(nomf, sizeof(nomf), "%s/K%svK%s.fin", argv[2], cotes[i], cotes[j]);
+					if (stat(nomf, &st) == 0)
+						continue; // déjà générée (et chargée)
+					printf("K%svK%s ... ", cotes[i], cotes[j]);
+					fflush(stdout);
+					clock_gettime(CLOCK_MONOTONIC, &t0);
+					if (!genererFinale(nomf, nb, distances, nbThreads) || !chargerFinale(nomf))
+					{
+						printf("échec\n");
+						return 1;
+					}
+					clock_gettime(CLOCK_MONOTONIC, &t1);
+					printf("%.1f s (distance max %d)\n",
+						   (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9, genNiveau);
+				}
+	return 0;
+
+} // fin de finalesMain
+
+// ********************************
+// Partie:  Livre d'ouvertures
+// ********************************
 
-int confcmp123(const void *a, const void *b) // pour l'ordre croissant
+/* Entier de n octets rangé du poids fort au poids faible à partir de p */
+bitboard lireGrosBout(unsigned char *p, int n)
 {
-	int x = ((struct config *)a)->val, y = ((struct config *)b)->val;
-	if (x < y)
-		return -1;
-	if (x == y)
-		return 0;
-	return 1;
-} // fin confcmp123
+	bitboard v = 0;
+
+	while (n-- > 0)
+		v = (v << 8) | *p++;
+	return v;
+} // fin de lireGrosBout
 
-int confcmp321(const void *a, const void *b) // pour l'ordre decroissant
+/* Range v sur n octets du poids fort au poids faible à partir de p */
+void ecrireGrosBout(unsigned char *p, bitboard v, int n)
 {
-	int x = ((struct config *)a)->val, y = ((struct config *)b)->val;
-	if (x > y)
-		return -1;
-	if (x == y)
+	while (n-- > 0)
+	{
+		p[n] = v & 0xFF;
+		v >>= 8;
+	}
+} // fin de ecrireGrosBout
+
+/* En-tête d'un livre dans e : signature puis valeur de contrôle des clés de Zobrist */
+void enteteLivre(unsigned char *e)
+{
+	memset(e, 0, TAILLE_ENTREE_LIVRE);
+	strcpy((char *)e, SIGNATURE_LIVRE);
+	ecrireGrosBout(e + 8, controleCache(), 8);
+} // fin de enteteLivre
+
+/* Projette le livre nomf en mémoire (le fichier peut être fermé une fois projeté),
+   ses entrées suivant l'en-tête */
+int ouvrirLivre(char *nomf)
+{
+	int fd;
+	struct stat st;
+	void *m;
+	unsigned char e[TAILLE_ENTREE_LIVRE];
+
+	fd = open(nomf, O_RDONLY);
+	if (fd < 0)
+		return 0;
+	if (fstat(fd, &st) != 0 || st.st_size < 2 * TAILLE_ENTREE_LIVRE ||
+		(m = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED)
+	{
+		close(fd);
+		return 0;
+	}
+	close(fd);
+	enteteLivre(e);
+	if (memcmp(m, e, TAILLE_ENTREE_LIVRE) != 0)
+	{
+		munmap(m, st.st_size);
 		return 0;
+	}
+	livre = (unsigned char *)m + TAILLE_ENTREE_LIVRE;
+	nbEntreesLivre = st.st_size / TAILLE_ENTREE_LIVRE - 1;
 	return 1;
-} // fin confcmp321
 
-/* MinMax avec élagage alpha-beta :
- Evalue la configuration 'conf' du joueur 'mode' en descendant de 'niv' niveaux.
- Le paramètre 'niv' est decrémenté à chaque niveau (appel récursif).
- 'alpha' et 'beta' représentent les bornes initiales de l'intervalle d'intérêt 
- (pour pouvoir effectuer les coupes alpha et bêta).
- 'largeur' représente le nombre max d'alternatives à explorer en profondeur à chaque niveau.
- Si 'largeur == +INFINI' toutes les alternatives seront prises en compte 
- (c'est le comportement par défaut).
- 'numFctEst' est le numéro de la fonction d'estimation à utiliser lorsqu'on arrive à la
- frontière d'exploration (c-a-d 'niv' atteint 0)
-*/
-int minmax_ab(struct config *conf, int mode, int niv, int alpha, int beta, int largeur, int numFctEst)
+} // fin de ouvrirLivre
+
+/* Code Polyglot de c : colonne et rangée d'arrivée (bits 0 à 5), de départ (bits 6 à 11)
+   et pièce de promotion (bits 12 à 14 : 1 cavalier, 2 fou, 3 tour, 4 reine) */
+unsigned short coupPolyglot(Coup c)
 {
-	int n, i, score, score2;
-	struct config T[100];
+	int de = DE(c), vers = VERS(c), promo = 0;
 
-	if (feuille(conf, &score))
-		return score;
+	if (EST_ROQUE(c))
+		vers = CASE(LIGNE(de), (DRAP(c) & P_ROQUE ? 7 : 0));
+	if (EST_PROMO(c))
+		promo = PIECE_PROMO(c) - CAVALIER + 1;
+	return COLONNE(vers) | (LIGNE(vers) << 3) | (COLONNE(de) << 6) | (LIGNE(de) << 9) | (promo << 12);
 
-	if (niv == 0)
-		return Est[numFctEst](conf);
+} // fin de coupPolyglot
 
-	if (mode == MAX)
-	{
+/* Coup du livre pour conf (recherche dichotomique de la 1re entrée de sa clé) */
+int coupLivre(struct config *conf, struct listeCoups *L, Coup *c)
+{
+	long deb = 0, fin = nbEntreesLivre, k;
+	int i, n = 0, poids[MAXCOUPS], total = 0, r;
+	Coup coups[MAXCOUPS];
+	unsigned char *e;
 
-		generer_succ(conf, MAX, T, &n);
+	if (livre == NULL)
+		return 0;
 
-		if (largeur != +INFINI)
-		{
-			for (i = 0; i < n; i++)
-				T[i].val = Est[numFctEst](&T[i]);
+	while (deb < fin)
+	{
+		k = (deb + fin) / 2;
+		if (lireGrosBout(livre + k * TAILLE_ENTREE_LIVRE, 8) < conf->cle)
+			deb = k + 1;
+		else
+			fin = k;
+	}
 
-			qsort(T, n, sizeof(struct config), confcmp321);
-			if (largeur < n)
-				n = largeur; // pour limiter la largeur d'exploration
+	// les coups du livre pour cette clé qui sont des coups légaux (et de poids non nul)
+	for (k = deb; k < nbEntreesLivre; k++)
+	{
+		e = livre + k * TAILLE_ENTREE_LIVRE;
+		if (lireGrosBout(e, 8) != conf->cle)
+			break;
+		for (i = 0; i < L->n; i++)
+			if (coupPolyglot(L->c[i]) == lireGrosBout(e + 8, 2))
+				break;
+		if (i < L->n && lireGrosBout(e + 10, 2) > 0 && n < MAXCOUPS)
+		{
+			coups[n] = L->c[i];
+			poids[n] = lireGrosBout(e + 10, 2);
+			total += poids[n++];
 		}
+	}
+	if (n == 0)
+		return 0;
 
-		score = alpha;
-		for (i = 0; i < n; i++)
-		{
-			score2 = minmax_ab(&T[i], MIN, niv - 1, score, beta, largeur, numFctEst);
-			if (score2 > score)
-				score = score2;
-			if (score >= beta)
+	*c = coups[0];
+	if (livreMeilleur)
+	{
+		for (i = 1; i < n; i++)
+			if (poids[i] > poids[0])
 			{
-				// Coupe Beta
-				nbBeta++; // compteur de courpes beta
-				return beta;
+				poids[0] = poids[i];
+				*c = coups[i];
 			}
-		}
 	}
 	else
-	{ // mode == MIN
+	{
+		r = rand() % total;
+		for (i = 0; r >= poids[i]; i++)
+			r -= poids[i];
+		*c = coups[i];
+	}
+	return 1;
+
+} // fin de coupLivre
+
+/* Texte du coup c : cases de départ et d'arrivée, suivies de la pièce obtenue par une promotion
+   (n, b, r ou q) ; un roque est noté par le déplacement du roi (par exemple e1g1) */
+void texteCoup(Coup c, char *texte)
+{
+	sprintf(texte, "%c%d%c%d", 'a' + COLONNE(DE(c)), LIGNE(DE(c)) + 1, 'a' + COLONNE(VERS(c)), LIGNE(VERS(c)) + 1);
+	if (EST_PROMO(c))
+	{
+		texte[4] = "nbrq"[PIECE_PROMO(c) - CAVALIER];
+		texte[5] = '\0';
+	}
+} // fin de texteCoup
+
+/* Ordre des entrées d'un livre : par clé puis par coup */
+int entreeLivreCmp(const void *a, const void *b)
+{
+	const struct entreeLivre *x = a, *y = b;
 
-		generer_succ(conf, MIN, T, &n);
+	if (x->cle != y->cle)
+		return (x->cle < y->cle ? -1 : 1);
+	return (int)x->coup - (int)y->coup;
+} // fin de entreeLivreCmp
+
+/* Construction d'un livre : chaque position rencontrée dans les lignes du fichier texte 
+   donne une entrée (clé, coup joué) dont le poids est le nombre de fois où le coup y a été joué,
+   les entrées étant écrites après l'en-tête qui les lie aux clés de Zobrist du programme */
+int livreMain(int argc, char *argv[])
+{
+	FILE *fl;
+	char ligne[1024], texte[8], *mot;
+	int i, j, mode, num = 0, n = 0, taille = 1024;
+	struct entreeLivre *T;
+	struct config conf;
+	struct listeCoups L;
+	struct annul u;
+	unsigned char e[TAILLE_ENTREE_LIVRE];
+
+	if (argc < 4)
+	{
+		printf("usage : %s livre <livre.bin> <ouvertures.txt>\n", argv[0]);
+		return 1;
+	}
+	fl = fopen(argv[3], "r");
+	if (fl == NULL)
+	{
+		printf("Fichier '%s' introuvable\n", argv[3]);
+		return 1;
+	}
+	initBitboards();
+	T = malloc(taille * sizeof(struct entreeLivre));
 
-		if (largeur != +INFINI)
+	while (fgets(ligne, sizeof(ligne), fl))
+	{
+		num++;
+		init(&conf);
+		mode = MAX;
+		for (mot = strtok(ligne, " \t\r\n"); mot; mot = strtok(NULL, " \t\r\n"))
 		{
-			for (i = 0; i < n; i++)
-				T[i].val = Est[numFctEst](&T[i]);
+			// retrouver le coup (par exemple e2e4, e7e8q, ou e1g1 pour un roque) parmi les coups légaux
+			generer_coups(&conf, mode, &L);
+			for (i = 0; i < L.n; i++)
+			{
+				texteCoup(L.c[i], texte);
+				if (strcmp(texte, mot) == 0)
+					break;
+			}
+			if (i == L.n)
+			{
+				printf("Ligne %d : coup '%s' illégal, fin de ligne ignorée\n", num, mot);
+				break;
+			}
+			if (n == taille)
+			{
+				taille *= 2;
+				T = realloc(T, taille * sizeof(struct entreeLivre));
+			}
+			T[n].cle = conf.cle;
+			T[n].coup = coupPolyglot(L.c[i]);
+			T[n++].poids = 1;
+			jouerCoup(&conf, L.c[i], &u);
+			mode = -mode;
+		}
+	}
+	fclose(fl);
 
-			qsort(T, n, sizeof(struct config), confcmp123);
-			if (largeur < n)
-				n = largeur; // pour limiter la largeur d'exploration
+	// regrouper les mêmes coups joués dans les mêmes positions, puis écrire le livre trié par clé
+	qsort(T, n, sizeof(struct entreeLivre), entreeLivreCmp);
+	for (i = 0, j = -1; i < n; i++)
+		if (j >= 0 && T[j].cle == T[i].cle && T[j].coup == T[i].coup)
+		{
+			if (T[j].poids < 0xFFFF)
+				T[j].poids++;
 		}
+		else
+			T[++j] = T[i];
 
-		score = beta;
-		for (i = 0; i < n; i++)
+	fl = fopen(argv[2], "wb");
+	if (fl == NULL)
+	{
+		printf("Impossible de créer '%s'\n", argv[2]);
+		return 1;
+	}
+	enteteLivre(e);
+	fwrite(e, TAILLE_ENTREE_LIVRE, 1, fl);
+	memset(e, 0, sizeof(e));
+	for (i = 0; i <= j; i++)
+	{
+		ecrireGrosBout(e, T[i].cle, 8);
+		ecrireGrosBout(e + 8, T[i].coup, 2);
+		ecrireGrosBout(e + 10, T[i].poids, 2);
+		fwrite(e, TAILLE_ENTREE_LIVRE, 1, fl);
+	}
+	fclose(fl);
+	free(T);
+	printf("%d entrées écrites dans '%s' (%d lignes)\n", j + 1, argv[2], num);
+	return 0;
+
+} // fin de livreMain
+
+// ***************************************************
+// Partie:  Perft (test et mesure du générateur de coups)
+// ***************************************************
+
+/* Nombre de feuilles à la profondeur prof : au dernier niveau les coups sont comptés
+   sans être joués, et les sous-arbres déjà comptés sont retrouvés dans tablePerft */
+long long perft(struct config *conf, int mode, int prof)
+{
+	int i;
+	long long nb = 0;
+	bitboard cle = 0, d;
+	struct entreePerft *e = NULL;
+	struct listeCoups L;
+	struct annul u;
+
+	if (prof == 0)
+		return 1;
+
+	if (tablePerft != NULL && prof > 1)
+	{
+		cle = conf->cle;
+		e = &tablePerft[cle & masquePerft];
+		d = e->donnee;
+		if ((e->verif ^ d) == cle && (int)(d & 0xFF) == prof)
+			return d >> 8;
+	}
+
+	generer_coups(conf, mode, &L);
+	if (prof == 1)
+		return L.n;
+
+	for (i = 0; i < L.n; i++)
+	{
+		jouerCoup(conf, L.c[i], &u);
+		nb += perft(conf, -mode, prof - 1);
+		dejouerCoup(conf, L.c[i], &u);
+	}
+
+	if (e != NULL)
+	{
+		d = ((bitboard)nb << 8) | prof;
+		e->donnee = d;
+		e->verif = cle ^ d;
+	}
+	return nb;
+
+} // fin de perft
+
+/* Thread du perft : prend les coups de la racine un par un jusqu'à épuisement */
+void *perftThread(void *arg)
+{
+	int i;
+	struct config conf = perftRacine;
+	struct annul u;
+
+	(void)arg;
+	while ((i = __sync_fetch_and_add(&perftProchain, 1)) < perftL.n)
+	{
+		jouerCoup(&conf, perftL.c[i], &u);
+		perftNb[i] = perft(&conf, -perftMode, perftProf - 1);
+		dejouerCoup(&conf, perftL.c[i], &u);
+	}
+	return NULL;
+
+} // fin de perftThread
+
+/* Programme perft : compte les feuilles depuis la configuration initiale (ou une FEN), 
+   avec le détail par coup de la racine (-divide), une table de hachage de taille donnée
+   en Mo (-hash, indexée par la clé de Zobrist) et les coups de la racine répartis sur
+   plusieurs threads (-threads).
+   Les règles sont celles du moteur (pas de prise en passant, un pion peut rester pion 
+   sur la dernière rangée) : les résultats ne coïncident avec les valeurs de référence 
+   des échecs standards que jusqu'à la profondeur 4 depuis la position initiale */
+int perftMain(int argc, char *argv[])
+{
+	int i, divide = 0, nbThreads = 1;
+	long long total = 0;
+	double duree;
+	bitboard taille;
+	char *fen = NULL;
+	struct timespec t0, t1;
+	pthread_t th[64];
+
+	if (argc < 3 || (perftProf = atoi(argv[2])) < 1)
+	{
+		printf("usage : %s perft <prof> [-fen \"<FEN>\"] [-divide] [-hash <Mo>] [-threads <n>]\n", argv[0]);
+		return 1;
+	}
+	initBitboards();
+	init(&perftRacine);
+	perftMode = MAX;
+
+	for (i = 3; i < argc; i++)
+		if (strcmp(argv[i], "-fen") == 0 && i + 1 < argc)
+			fen = argv[++i];
+		else if (strcmp(argv[i], "-divide") == 0)
+			divide = 1;
+		else if (strcmp(argv[i], "-hash") == 0 && i + 1 < argc)
 		{
-			score2 = minmax_ab(&T[i], MAX, niv - 1, alpha, score, largeur, numFctEst);
-			if (score2 < score)
-				score = score2;
-			if (score <= alpha)
+			// plus grande puissance de 2 d'entrées tenant dans la taille demandée
+			taille = (bitboard)atoi(argv[++i]) * 1024 * 1024 / sizeof(struct entreePerft);
+			if (taille > 0)
 			{
-				// Coupe Alpha
-				nbAlpha++; // compteur de courpes alpha
-				return alpha;
+				while (taille & (taille - 1))
+					taille &= taille - 1;
+				tablePerft = calloc(taille, sizeof(struct entreePerft));
+				masquePerft = taille - 1;
 			}
 		}
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+		{
+			nbThreads = atoi(argv[++i]);
+			if (nbThreads < 1)
+				nbThreads = 1;
+			if (nbThreads > 64)
+				nbThreads = 64;
+		}
+
+	if (fen != NULL && !lireFEN(&perftRacine, fen, &perftMode))
+	{
+		printf("FEN incorrecte : %s\n", fen);
+		return 1;
 	}
 
-	if (score == +INFINI)
-		score = +100;
-	if (score == -INFINI)
-		score = -100;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
 
-	return score;
+	generer_coups(&perftRacine, perftMode, &perftL);
+	perftProchain = 0;
+	if (perftProf == 1)
+	{
+		for (i = 0; i < perftL.n; i++)
+			perftNb[i] = 1;
+	}
+	else
+	{
+		for (i = 1; i < nbThreads; i++)
+			pthread_create(&th[i], NULL, perftThread, NULL);
+		perftThread(NULL);
+		for (i = 1; i < nbThreads; i++)
+			pthread_join(th[i], NULL);
+	}
 
-} // fin de minmax_ab
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	duree = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+	for (i = 0; i < perftL.n; i++)
+	{
+		total += perftNb[i];
+		if (divide)
+		{
+			printf("%c%d%c%d", 'a' + COLONNE(DE(perftL.c[i])), LIGNE(DE(perftL.c[i])) + 1,
+				   'a' + COLONNE(VERS(perftL.c[i])), LIGNE(VERS(perftL.c[i])) + 1);
+			if (EST_PROMO(perftL.c[i]))
+				printf("%c", codePiece[PIECE_PROMO(perftL.c[i])]);
+			printf(" : %lld\n", perftNb[i]);
+		}
+	}
+
+	printf("perft(%d) = %lld  en %.3f s  (%.0f noeuds/s)\n", perftProf, total, duree,
+		   (duree > 0 ? total / duree : 0.0));
+
+	free(tablePerft);
+	return 0;
+
+} // fin de perftMain